@@ -0,0 +1,192 @@
+//! Allocator traffic of a request-sized arena workload.
+//!
+//! Builds and encodes a Sample per iteration and counts the calls and bytes
+//! that reach the backing Zig allocator: with a fresh arena per iteration
+//! (default block sizing and a larger min_block_size), and with one arena
+//! that is reset between iterations.
+//!
+//! A decode workload then compares upb_zig.Arena against the bridge it
+//! replaced, which put a size header in front of every 16-byte aligned block.
+
+const std = @import("std");
+const upb_zig = @import("upb_zig");
+const benchmark_pb = @import("benchmark_zig_pb");
+
+const iterations: usize = 100_000;
+
+/// Wraps an allocator and counts the allocations that pass through it.
+const CountingAllocator = struct {
+    child: std.mem.Allocator,
+    allocations: usize = 0,
+    live_bytes: usize = 0,
+    peak_bytes: usize = 0,
+
+    fn allocator(self: *CountingAllocator) std.mem.Allocator {
+        return .{ .ptr = self, .vtable = &.{
+            .alloc = alloc,
+            .resize = resize,
+            .remap = remap,
+            .free = free,
+        } };
+    }
+
+    fn track(self: *CountingAllocator, old_len: usize, new_len: usize) void {
+        self.live_bytes = self.live_bytes - old_len + new_len;
+        self.peak_bytes = @max(self.peak_bytes, self.live_bytes);
+    }
+
+    fn alloc(ctx: *anyopaque, len: usize, alignment: std.mem.Alignment, ra: usize) ?[*]u8 {
+        const self: *CountingAllocator = @ptrCast(@alignCast(ctx));
+        const mem = self.child.rawAlloc(len, alignment, ra) orelse return null;
+        self.allocations += 1;
+        self.track(0, len);
+        return mem;
+    }
+
+    fn resize(ctx: *anyopaque, memory: []u8, alignment: std.mem.Alignment, new_len: usize, ra: usize) bool {
+        const self: *CountingAllocator = @ptrCast(@alignCast(ctx));
+        if (!self.child.rawResize(memory, alignment, new_len, ra)) return false;
+        self.track(memory.len, new_len);
+        return true;
+    }
+
+    fn remap(ctx: *anyopaque, memory: []u8, alignment: std.mem.Alignment, new_len: usize, ra: usize) ?[*]u8 {
+        const self: *CountingAllocator = @ptrCast(@alignCast(ctx));
+        const mem = self.child.rawRemap(memory, alignment, new_len, ra) orelse return null;
+        self.track(memory.len, new_len);
+        return mem;
+    }
+
+    fn free(ctx: *anyopaque, memory: []u8, alignment: std.mem.Alignment, ra: usize) void {
+        const self: *CountingAllocator = @ptrCast(@alignCast(ctx));
+        self.child.rawFree(memory, alignment, ra);
+        self.track(memory.len, 0);
+    }
+};
+
+const Lifecycle = enum { per_request, reset };
+
+fn report(name: []const u8, elapsed_ns: u64, counting: *const CountingAllocator) void {
+    std.debug.print("{s:<24} {d:>8.2} ns/iter {d:>6.2} allocs/iter  peak {d} bytes\n", .{
+        name,
+        @as(f64, @floatFromInt(elapsed_ns)) / @as(f64, @floatFromInt(iterations)),
+        @as(f64, @floatFromInt(counting.allocations)) / @as(f64, @floatFromInt(iterations)),
+        counting.peak_bytes,
+    });
+}
+
+// upb entry points for driving an arena over HeaderAlloc directly.
+const UpbAlloc = extern struct {
+    func: *const fn (*UpbAlloc, ?*anyopaque, usize, usize, ?*usize) callconv(.c) ?*anyopaque,
+};
+extern fn upb_Arena_Init(mem: ?*anyopaque, n: usize, alloc: *UpbAlloc) ?*upb_zig.upb_Arena;
+extern fn upb_Arena_Free(arena: *upb_zig.upb_Arena) void;
+extern fn upb_Message_New(mini_table: *const upb_zig.upb_MiniTable, arena: *upb_zig.upb_Arena) ?*upb_zig.upb_Message;
+extern fn upb_Decode(buf: [*]const u8, size: usize, msg: *upb_zig.upb_Message, mini_table: *const upb_zig.upb_MiniTable, extreg: ?*const anyopaque, options: c_int, arena: *upb_zig.upb_Arena) c_int;
+
+/// The allocator bridge upb_zig used before block sizes moved to a side
+/// table: a size header in front of every block, 16-byte aligned.
+const HeaderAlloc = struct {
+    upb_alloc: UpbAlloc = .{ .func = allocFn },
+    zig_allocator: std.mem.Allocator,
+
+    const header_size = @sizeOf(usize);
+
+    fn allocFn(alloc: *UpbAlloc, ptr: ?*anyopaque, oldsize: usize, size: usize, actual_size: ?*usize) callconv(.c) ?*anyopaque {
+        const self: *HeaderAlloc = @alignCast(@fieldParentPtr("upb_alloc", alloc));
+        _ = oldsize;
+        if (size == 0) {
+            const user: [*]u8 = @ptrCast(ptr orelse return null);
+            const base: [*]align(16) u8 = @alignCast(user - header_size);
+            const len = @as(*const usize, @ptrCast(base)).*;
+            self.zig_allocator.free(base[0 .. header_size + len]);
+            return null;
+        }
+        // upb never reallocates arena blocks, so this workload needs no realloc.
+        std.debug.assert(ptr == null);
+        const mem = self.zig_allocator.alignedAlloc(u8, .@"16", header_size + size) catch return null;
+        @as(*usize, @ptrCast(mem.ptr)).* = size;
+        if (actual_size) |n| n.* = size;
+        return mem.ptr + header_size;
+    }
+};
+
+const Bridge = enum { header, side_table };
+
+/// Decode `encoded` into a fresh arena per iteration through either bridge.
+fn runDecode(name: []const u8, bridge: Bridge, encoded: []const u8) !void {
+    var counting: CountingAllocator = .{ .child = std.heap.c_allocator };
+    benchmark_pb.Sample.ensureInit();
+    const mt = benchmark_pb.Sample.minitable.?;
+    var timer = try std.time.Timer.start();
+
+    for (0..iterations) |_| switch (bridge) {
+        .header => {
+            var header: HeaderAlloc = .{ .zig_allocator = counting.allocator() };
+            const arena = upb_Arena_Init(null, 0, &header.upb_alloc) orelse return error.OutOfMemory;
+            defer upb_Arena_Free(arena);
+            const msg = upb_Message_New(mt, arena) orelse return error.OutOfMemory;
+            if (upb_Decode(encoded.ptr, encoded.len, msg, mt, null, 0, arena) != 0) return error.DecodeFailed;
+        },
+        .side_table => {
+            const arena = try upb_zig.Arena.init(counting.allocator());
+            defer arena.deinit();
+            _ = try benchmark_pb.Sample.decode(arena, encoded);
+        },
+    };
+
+    report(name, timer.read(), &counting);
+}
+
+fn handleRequest(arena: upb_zig.Arena, i: usize) !void {
+    var sample = try benchmark_pb.Sample.init(arena);
+    sample.setId(@intCast(i % 1000));
+    sample.setName("arena allocation benchmark");
+    for (0..64) |j| {
+        try sample.addCounts(@intCast(j));
+    }
+    _ = try sample.encode();
+}
+
+fn run(name: []const u8, lifecycle: Lifecycle, options: upb_zig.ArenaOptions) !void {
+    var counting: CountingAllocator = .{ .child = std.heap.c_allocator };
+    var timer = try std.time.Timer.start();
+
+    switch (lifecycle) {
+        .per_request => for (0..iterations) |i| {
+            const arena = try upb_zig.Arena.initWithOptions(counting.allocator(), options);
+            defer arena.deinit();
+            try handleRequest(arena, i);
+        },
+        .reset => {
+            var arena = try upb_zig.Arena.initWithOptions(counting.allocator(), options);
+            defer arena.deinit();
+            for (0..iterations) |i| {
+                try handleRequest(arena, i);
+                try arena.reset();
+            }
+        },
+    }
+
+    report(name, timer.read(), &counting);
+}
+
+pub fn main() !void {
+    try run("default blocks", .per_request, .{});
+    try run("min_block_size 8 KiB", .per_request, .{ .min_block_size = 8 * 1024 });
+    try run("reset between requests", .reset, .{});
+
+    const arena = try upb_zig.Arena.init(std.heap.c_allocator);
+    defer arena.deinit();
+    var sample = try benchmark_pb.Sample.init(arena);
+    sample.setName("arena allocation benchmark");
+    for (0..64) |j| {
+        try sample.addCounts(@intCast(j));
+    }
+    const encoded = try sample.encode();
+    try runDecode("decode, header bridge", .header, encoded);
+    try runDecode("decode, side table", .side_table, encoded);
+
+    const usage = std.posix.getrusage(std.posix.rusage.SELF);
+    std.debug.print("max RSS {d} KiB\n", .{usage.maxrss});
+}
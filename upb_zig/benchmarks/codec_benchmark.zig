@@ -0,0 +1,74 @@
+//! Microbenchmark for generated accessors and wire encode/decode.
+//!
+//! Run with the C side at its default and at matching optimization levels:
+//!   bazel run -c opt //upb_zig/benchmarks:codec_benchmark
+//!   bazel run --config=opt_fast //upb_zig/benchmarks:codec_benchmark
+//! Neither is LTO; upb_zig/runtime/lto_benchmark.zig measures that.
+
+const std = @import("std");
+const upb_zig = @import("upb_zig");
+const benchmark_pb = @import("benchmark_zig_pb");
+
+const accessor_iterations: usize = 10_000_000;
+const codec_iterations: usize = 200_000;
+
+fn report(name: []const u8, elapsed_ns: u64, iterations: usize) void {
+    const per_op = @as(f64, @floatFromInt(elapsed_ns)) / @as(f64, @floatFromInt(iterations));
+    std.debug.print("{s:<20} {d:>8.2} ns/op\n", .{ name, per_op });
+}
+
+pub fn main() !void {
+    const arena = try upb_zig.Arena.init(std.heap.page_allocator);
+    defer arena.deinit();
+
+    var sample = try benchmark_pb.Sample.init(arena);
+    sample.setId(42);
+    sample.setTimestamp(1_700_000_000);
+    sample.setValue(3.5);
+    sample.setName("benchmark sample");
+    sample.setPayload("0123456789abcdef0123456789abcdef");
+    const counts = [_]i32{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    try sample.addAllCounts(&counts);
+    try sample.reserveValues(counts.len);
+    for (counts) |i| {
+        try sample.addValues(@floatFromInt(i));
+    }
+
+    var timer = try std.time.Timer.start();
+
+    var sum: i64 = 0;
+    for (0..accessor_iterations) |i| {
+        sample.setId(@truncate(@as(i64, @intCast(i))));
+        sum +%= sample.getId();
+        sum +%= sample.getTimestamp();
+    }
+    report("scalar get/set", timer.lap(), accessor_iterations);
+
+    var len: usize = 0;
+    for (0..accessor_iterations) |_| {
+        len +%= sample.getName().len;
+    }
+    report("string get", timer.lap(), accessor_iterations);
+
+    // Encode and decode into a scratch arena so memory use stays flat.
+    const encoded = try sample.encode();
+    timer.reset();
+    for (0..codec_iterations) |_| {
+        const scratch = try upb_zig.Arena.init(std.heap.page_allocator);
+        defer scratch.deinit();
+        const decoded = try benchmark_pb.Sample.decode(scratch, encoded);
+        len +%= (try decoded.encode()).len;
+    }
+    report("decode + encode", timer.lap(), codec_iterations);
+
+    for (0..codec_iterations) |_| {
+        const scratch = try upb_zig.Arena.init(std.heap.page_allocator);
+        defer scratch.deinit();
+        const decoded = try benchmark_pb.Sample.decodeWithOptions(scratch, encoded, .{ .alias_string = true });
+        len +%= decoded.getPayload().len;
+    }
+    report("decode (aliased)", timer.lap(), codec_iterations);
+
+    std.mem.doNotOptimizeAway(sum);
+    std.mem.doNotOptimizeAway(len);
+}
@@ -0,0 +1,57 @@
+//! Microbenchmark for generated scalar accessors.
+//!
+//! Compares looking up the MiniTableField by field number on every access
+//! (what generated getters used to do) against the per-type field table that
+//! generated messages resolve once in _file_init(), and per-element
+//! repeated getters against the in-place slice view.
+
+const std = @import("std");
+const upb_zig = @import("upb_zig");
+const benchmark_pb = @import("benchmark_zig_pb");
+
+const iterations: usize = 10_000_000;
+
+fn report(name: []const u8, elapsed_ns: u64) void {
+    const per_op = @as(f64, @floatFromInt(elapsed_ns)) / @as(f64, @floatFromInt(iterations));
+    std.debug.print("{s:<28} {d:>8.2} ns/op\n", .{ name, per_op });
+}
+
+pub fn main() !void {
+    const arena = try upb_zig.Arena.init(std.heap.page_allocator);
+    defer arena.deinit();
+
+    var sample = try benchmark_pb.Sample.init(arena);
+    sample.setId(42);
+
+    const mt = benchmark_pb.Sample.minitable orelse return error.MissingMiniTable;
+    var sum: i64 = 0;
+    var timer = try std.time.Timer.start();
+
+    // Previous accessor path: resolve the field by number on every read.
+    for (0..iterations) |_| {
+        const field = upb_zig.findFieldByNumber(mt, benchmark_pb.Sample.FieldNumber.id) orelse unreachable;
+        sum +%= upb_zig.getInt32(sample._msg, field, 0);
+    }
+    report("lookup per access", timer.lap());
+
+    // Generated accessor: indexed load from the resolved field table.
+    for (0..iterations) |_| {
+        sum +%= sample.getId();
+    }
+    report("resolved field table", timer.lap());
+
+    // Repeated field: one C call per element against a slice view.
+    for (0..1024) |i| try sample.addCounts(@intCast(i));
+    timer.reset();
+    for (0..iterations / 1024) |_| {
+        for (0..sample.countsCount()) |i| sum +%= sample.getCounts(i);
+    }
+    report("repeated get(i)", timer.lap());
+
+    for (0..iterations / 1024) |_| {
+        for (sample.getCountsSlice()) |v| sum +%= v;
+    }
+    report("repeated slice", timer.lap());
+
+    std.mem.doNotOptimizeAway(sum);
+}
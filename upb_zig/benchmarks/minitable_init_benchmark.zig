@@ -0,0 +1,37 @@
+//! Startup cost of each MiniTableMode.
+//!
+//! Each mode can only be measured once per process, so the mode is chosen on
+//! the command line:
+//!   bazel run -c opt //upb_zig/benchmarks:minitable_init_benchmark -- lazy
+
+const std = @import("std");
+const upb_zig = @import("upb_zig");
+const benchmark_pb = @import("benchmark_zig_pb");
+
+pub fn main() !void {
+    const args = try std.process.argsAlloc(std.heap.page_allocator);
+    defer std.process.argsFree(std.heap.page_allocator, args);
+
+    const mode_name = if (args.len > 1) args[1] else "eager";
+    const mode = std.meta.stringToEnum(upb_zig.MiniTableMode, mode_name) orelse {
+        std.debug.print("usage: minitable_init_benchmark [def_pool|eager|lazy]\n", .{});
+        return error.InvalidMode;
+    };
+    benchmark_pb.minitable_mode = mode;
+
+    const arena = try upb_zig.Arena.init(std.heap.page_allocator);
+    defer arena.deinit();
+
+    // First touch: builds (or loads) the MiniTables for Sample.
+    var timer = try std.time.Timer.start();
+    var sample = try benchmark_pb.Sample.init(arena);
+    const first_use_ns = timer.read();
+    sample.setId(1);
+
+    const usage = std.posix.getrusage(std.posix.rusage.SELF);
+    std.debug.print("{s:<10} first use {d:>8.2} us, max RSS {d} KiB\n", .{
+        @tagName(mode),
+        @as(f64, @floatFromInt(first_use_ns)) / 1000.0,
+        usage.maxrss,
+    });
+}
@@ -205,7 +205,7 @@ test "nested message setter then getter" {
 
     var request = try conformance_pb.ConformanceRequest.init(arena);
 
-    request.setJspbEncodingOptions(config);
+    try request.setJspbEncodingOptions(config);
 
     try std.testing.expect(request.getJspbEncodingOptions() != null);
 }
@@ -0,0 +1,8 @@
+//! The conformance testee built with native_accessors, so the Zig mirror of
+//! upb's field layout goes through the same suite as the C accessors.
+
+const upb_zig = @import("upb_zig");
+
+pub const upb_zig_options: upb_zig.Options = .{ .native_accessors = true };
+
+pub const main = @import("conformance_testee.zig").main;
@@ -11,7 +11,10 @@ from google.protobuf.descriptor_pb2 import ( # pyright: ignore[reportMissingModu
     FieldDescriptorProto,
     EnumDescriptorProto,
 )
-from typing import Dict, Optional, List
+import re
+from typing import Callable, Dict, Optional, List
+
+from upb_zig.plugin.mini_descriptor import TypeIndex
 
 # -------------- CONSTANTS --------------
 # Zig reserved keywords that need escaping with @""
@@ -26,6 +29,9 @@ ZIG_KEYWORDS = {
     'var', 'volatile', 'while',
 }
 
+# Values accepted by the minitable_mode plugin parameter (upb_zig.MiniTableMode)
+MINITABLE_MODES = ("def_pool", "eager", "lazy")
+
 # Mapping from protobuf field types to Zig types
 PROTO_TYPE_TO_ZIG = {
     FieldDescriptorProto.TYPE_DOUBLE: "f64",
@@ -109,10 +115,11 @@ pub const ${message.name} = struct {
     _arena: upb_zig.Arena,
 
     /// MiniTable descriptor for this message type.
-    /// Initialized from embedded FileDescriptor on first use.
+    /// Built on first use, as selected by this file's `minitable_mode`.
     pub var minitable: ?*const upb_zig.upb_MiniTable = null;
 
     /// MessageDef for this message type (needed for JSON encode/decode).
+    /// Loaded from the shared DefPool the first time JSON is used.
     pub var msgdef: ?*const upb_zig.upb_MessageDef = null;
 
     /// Field numbers for this message
@@ -122,21 +129,64 @@ pub const ${message.name} = struct {
 % endfor
     };
 
-    /// Cached field descriptors - populated on first access
-    var fields_initialized: bool = false;
+    /// Position of each field in `fields` (declaration order)
+    const FieldIndex = struct {
+% for field in message.field:
+        const ${escape_zig_keyword(field.name)}: usize = ${loop.index};
+% endfor
+    };
+
+    /// Position of this message in the file's MiniTable arrays.
+    const table_index: usize = ${table_index};
+
+    /// Field descriptors indexed by FieldIndex.
+    /// Resolved once per message type by _resolveFields().
     var fields: [${len(message.field)}]?*const upb_zig.upb_MiniTableField = .{null} ** ${len(message.field)};
 
     /// Initialize the MiniTable for this message type.
-    /// Called automatically when needed; safe to call multiple times.
+    /// Called automatically when needed; safe to call multiple times and
+    /// from multiple threads. Once initialized this is a single acquire load.
     pub fn ensureInit() void {
+        if (@atomicLoad(?*const upb_zig.upb_MiniTable, &minitable, .acquire) != null) return;
+        upb_zig.lockInit();
+        defer upb_zig.unlockInit();
         if (minitable != null) return;
-        _file_init();
+        const mt = _messageMiniTable(table_index) orelse return;
+        _resolveFields(mt);
+        @atomicStore(?*const upb_zig.upb_MiniTable, &minitable, mt, .release);
     }
 
-    fn getField(field_number: u32) ?*const upb_zig.upb_MiniTableField {
-        ensureInit();
-        const mt = minitable orelse return null;
-        return upb_zig.findFieldByNumber(mt, field_number);
+    /// ensureInit(), unless the root module sets upb_zig_options.assume_warm
+    /// (having called warmUp first), in which case the check compiles away.
+    inline fn checkInit() void {
+        if (comptime upb_zig.root_options.assume_warm) {
+            std.debug.assert(minitable != null);
+        } else {
+            ensureInit();
+        }
+    }
+
+    /// Initialize the MessageDef used by JSON encode/decode.
+    /// The wire format path never needs it.
+    pub fn ensureJsonInit() void {
+        if (@atomicLoad(?*const upb_zig.upb_MessageDef, &msgdef, .acquire) != null) return;
+        _json_init();
+    }
+
+    /// Resolve every field descriptor against the MiniTable.
+    /// Called by ensureInit() before the MiniTable is published.
+    fn _resolveFields(mt: *const upb_zig.upb_MiniTable) void {
+% if not message.field:
+        _ = mt;
+% endif
+% for field in message.field:
+        fields[FieldIndex.${escape_zig_keyword(field.name)}] = upb_zig.findFieldByNumber(mt, FieldNumber.${escape_zig_keyword(field.name)});
+% endfor
+    }
+
+    fn fieldAt(index: usize) ?*const upb_zig.upb_MiniTableField {
+        checkInit();
+        return fields[index];
     }
 
     // Nested enums
@@ -156,13 +206,9 @@ pub const ${message.name} = struct {
     };
 % endfor
 
-    // Nested messages (simplified - just type alias for now)
-% for nested_msg in message.nested_type:
-    pub const ${nested_msg.name} = struct {
-        _msg: *upb_zig.upb_Message,
-        _arena: upb_zig.Arena,
-        pub var minitable: ?*const upb_zig.upb_MiniTable = null;
-    };
+    // Nested messages
+% for nested_code in nested_messages:
+${nested_code}
 % endfor
 
     // Oneofs
@@ -176,7 +222,7 @@ pub const ${message.name} = struct {
 
     pub fn ${snake_to_camel(oneof_name)}Case(self: *const ${message.name}) ${pascal_case(oneof_name)}Case {
     % for f in oneof_fields:
-        if (getField(FieldNumber.${escape_zig_keyword(f.name)})) |fd| {
+        if (fieldAt(FieldIndex.${escape_zig_keyword(f.name)})) |fd| {
             if (upb_zig.hasField(self._msg, fd)) return .${escape_zig_keyword(f.name)};
         }
     % endfor
@@ -186,102 +232,337 @@ pub const ${message.name} = struct {
 
 % for field in message.field:
     /// ${field.name} field (${field_type_name(field)}, field number ${field.number})
-% if is_repeated(field):
+<% map_field = map_info(field) %>\
+% if map_field:
+    pub fn ${snake_to_camel(field.name)}Count(self: *const ${message.name}) usize {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return 0;
+        return upb_zig.mapCount(self._msg, field_desc);
+    }
+
+    /// Look up the ${field.name} entry for `key`.
+    pub fn get${pascal_case(field.name)}(self: *const ${message.name}, key: ${map_field["key"]}) ?${map_field["value"]} {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return null;
+        const raw = upb_zig.mapGet(${map_field["key"]}, ${map_field["raw"]}, self._msg, field_desc, key) orelse return null;
+  % if map_field["kind"] == "enum":
+        return ${map_field["value"]}.fromInt(raw) orelse @enumFromInt(0);
+  % elif map_field["kind"] == "message":
+        return ${map_field["value"]}{ ._msg = raw, ._arena = self._arena };
+  % else:
+        return raw;
+  % endif
+    }
+
+  % if map_field["kind"] == "message":
+    /// Insert or replace the ${field.name} entry for `key`, fusing `value`'s
+    /// arena into this message's arena as message setters do.
+  % else:
+    /// Insert or replace the ${field.name} entry for `key`.
+  % endif
+    pub fn put${pascal_case(field.name)}(self: *${message.name}, key: ${map_field["key"]}, value: ${map_field["value"]}) !void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        const mt = minitable orelse return error.OutOfMemory;
+  % if map_field["kind"] == "enum":
+        try upb_zig.mapPut(${map_field["key"]}, i32, self._msg, mt, field_desc, key, value.toInt(), self._arena);
+  % elif map_field["kind"] == "message":
+        const sub_msg = try upb_zig.adoptMessage(self._arena, value._arena, value._msg);
+        try upb_zig.mapPut(${map_field["key"]}, *upb_zig.upb_Message, self._msg, mt, field_desc, key, sub_msg, self._arena);
+  % else:
+        try upb_zig.mapPut(${map_field["key"]}, ${map_field["raw"]}, self._msg, mt, field_desc, key, value, self._arena);
+  % endif
+    }
+
+    /// Remove the ${field.name} entry for `key`. Returns whether it was present.
+    pub fn remove${pascal_case(field.name)}(self: *${message.name}, key: ${map_field["key"]}) bool {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return false;
+        return upb_zig.mapRemove(${map_field["key"]}, self._msg, field_desc, key);
+    }
+
+    /// Remove every ${field.name} entry.
+    pub fn clear${pascal_case(field.name)}(self: *${message.name}) void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return;
+        upb_zig.mapClear(self._msg, field_desc);
+    }
+
+    /// Iterates the ${field.name} entries in unspecified order without
+    /// allocating. Finish iterating before putting or removing entries.
+    pub const ${pascal_case(field.name)}Iterator = struct {
+        inner: upb_zig.MapIterator(${map_field["key"]}, ${map_field["raw"]}),
+        _arena: upb_zig.Arena,
+
+        pub const Entry = struct { key: ${map_field["key"]}, value: ${map_field["value"]} };
+
+        pub fn next(self: *@This()) ?Entry {
+            const entry = self.inner.next() orelse return null;
+  % if map_field["kind"] == "enum":
+            return .{ .key = entry.key, .value = ${map_field["value"]}.fromInt(entry.value) orelse @enumFromInt(0) };
+  % elif map_field["kind"] == "message":
+            return .{ .key = entry.key, .value = ${map_field["value"]}{ ._msg = entry.value, ._arena = self._arena } };
+  % else:
+            return .{ .key = entry.key, .value = entry.value };
+  % endif
+        }
+    };
+
+    pub fn ${snake_to_camel(field.name)}Iterator(self: *const ${message.name}) ${pascal_case(field.name)}Iterator {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse
+            return .{ .inner = .{ .map = null }, ._arena = self._arena };
+        return .{
+            .inner = upb_zig.mapIterator(${map_field["key"]}, ${map_field["raw"]}, self._msg, field_desc),
+            ._arena = self._arena,
+        };
+    }
+% elif is_repeated(field):
     pub fn ${snake_to_camel(field.name)}Count(self: *const ${message.name}) usize {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return 0;
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return 0;
         return upb_zig.getArrayLen(self._msg, field_desc);
     }
 
+    /// Make room for `n` more ${field.name} elements, so the appends that
+    /// follow don't reallocate.
+    pub fn reserve${pascal_case(field.name)}(self: *${message.name}, n: usize) !void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        try upb_zig.arrayReserve(self._msg, field_desc, n, self._arena);
+    }
+
+    /// Shorten ${field.name} to at most `len` elements.
+    pub fn truncate${pascal_case(field.name)}(self: *${message.name}, len: usize) void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return;
+        upb_zig.arrayTruncate(self._msg, field_desc, len, self._arena);
+    }
+
+    /// Remove every ${field.name} element.
+    pub fn clear${pascal_case(field.name)}(self: *${message.name}) void {
+        self.truncate${pascal_case(field.name)}(0);
+    }
+
+    /// Remove the ${field.name} element at `index` by moving the last
+    /// element into its place (does not preserve order).
+    pub fn swapRemove${pascal_case(field.name)}(self: *${message.name}, index: usize) !void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        try upb_zig.arraySwapRemove(${zig_type(field) if is_scalar(field) or is_enum(field) else "*upb_zig.upb_Message"}, self._msg, field_desc, index, self._arena);
+    }
+  % if is_scalar(field) or is_enum(field):
+
+    /// Append all of `values` with one resize and one copy.
+    pub fn addAll${pascal_case(field.name)}(self: *${message.name}, values: []const ${zig_type(field)}) !void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        try upb_zig.arrayAppendSlice(${zig_type(field)}, self._msg, field_desc, values, self._arena);
+    }
+
+    /// Replace the ${field.name} elements with `values`.
+    pub fn setAll${pascal_case(field.name)}(self: *${message.name}, values: []const ${zig_type(field)}) !void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        try upb_zig.arraySetSlice(${zig_type(field)}, self._msg, field_desc, values, self._arena);
+    }
+  % endif
+
   % if is_scalar(field):
     pub fn get${pascal_case(field.name)}(self: *const ${message.name}, index: usize) ${zig_type(field)} {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return ${default_value(field)};
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return ${default_value(field)};
         return ${array_getter_fn(field)}(self._msg, field_desc, index);
     }
 
     pub fn add${pascal_case(field.name)}(self: *${message.name}, value: ${zig_type(field)}) !void {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
         try ${array_appender_fn(field)}(self._msg, field_desc, value, self._arena);
     }
+
+    /// Overwrite the ${field.name} element at `index`.
+    pub fn set${pascal_case(field.name)}At(self: *${message.name}, index: usize, value: ${zig_type(field)}) !void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        try upb_zig.arraySet(${zig_type(field)}, self._msg, field_desc, index, value);
+    }
+    % if is_packable(field):
+
+    /// All ${field.name} elements, read straight from the message's arena
+    /// without copying. Elements added later are not in the slice, and
+    /// set${pascal_case(field.name)}At writes show through it only until an
+    /// add moves the storage.
+    pub fn get${pascal_case(field.name)}Slice(self: *const ${message.name}) []const ${zig_type(field)} {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return &.{};
+        return upb_zig.arraySlice(${zig_type(field)}, self._msg, field_desc);
+    }
+    % endif
   % elif is_enum(field):
     pub fn get${pascal_case(field.name)}(self: *const ${message.name}, index: usize) ${zig_type(field)} {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return @enumFromInt(0);
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return @enumFromInt(0);
         const raw = upb_zig.arrayGetInt32(self._msg, field_desc, index);
         return ${zig_type(field)}.fromInt(raw) orelse @enumFromInt(0);
     }
 
     pub fn add${pascal_case(field.name)}(self: *${message.name}, value: ${zig_type(field)}) !void {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
         try upb_zig.arrayAppendInt32(self._msg, field_desc, value.toInt(), self._arena);
     }
+
+    /// Overwrite the ${field.name} element at `index`.
+    pub fn set${pascal_case(field.name)}At(self: *${message.name}, index: usize, value: ${zig_type(field)}) !void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        try upb_zig.arraySet(i32, self._msg, field_desc, index, value.toInt());
+    }
+
+    /// All ${field.name} elements as their raw i32 values, without copying.
+    /// Unlike get${pascal_case(field.name)}, unknown values of open enums are
+    /// kept instead of mapped to the zero value.
+    pub fn get${pascal_case(field.name)}Slice(self: *const ${message.name}) []const i32 {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return &.{};
+        return upb_zig.arraySlice(i32, self._msg, field_desc);
+    }
   % else:
     pub fn get${pascal_case(field.name)}(self: *const ${message.name}, index: usize) ?${zig_type(field)} {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return null;
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return null;
         const sub_msg = upb_zig.arrayGetMessage(self._msg, field_desc, index) orelse return null;
         return ${zig_type(field)}{ ._msg = sub_msg, ._arena = self._arena };
     }
 
+    /// Appends `value`, fusing its arena into this message's arena if they
+    /// differ. Fails with error.ArenaFuseFailed if either arena was created
+    /// with initWithBuffer; clone() `value` into this message's arena first
+    /// in that case.
     pub fn add${pascal_case(field.name)}(self: *${message.name}, value: ${zig_type(field)}) !void {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
-        try upb_zig.arrayAppendMessage(self._msg, field_desc, value._msg, self._arena);
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        const sub_msg = try upb_zig.adoptMessage(self._arena, value._arena, value._msg);
+        try upb_zig.arrayAppendMessage(self._msg, field_desc, sub_msg, self._arena);
+    }
+
+    /// Replace the ${field.name} element at `index`, fusing `value`'s arena
+    /// as add${pascal_case(field.name)} does.
+    pub fn set${pascal_case(field.name)}At(self: *${message.name}, index: usize, value: ${zig_type(field)}) !void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        const sub_msg = try upb_zig.adoptMessage(self._arena, value._arena, value._msg);
+        try upb_zig.arraySet(*upb_zig.upb_Message, self._msg, field_desc, index, sub_msg);
+    }
+
+    /// Append a new empty ${field.name} element allocated in this message's
+    /// arena and return it to be filled in.
+    pub fn addNew${pascal_case(field.name)}(self: *${message.name}) !${zig_type(field)} {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        const mt = minitable orelse return error.OutOfMemory;
+        const sub_msg = try upb_zig.arrayAppendNewMessage(self._msg, mt, field_desc, self._arena);
+        return ${zig_type(field)}{ ._msg = sub_msg, ._arena = self._arena };
     }
   % endif
 % elif is_scalar(field):
     pub fn get${pascal_case(field.name)}(self: *const ${message.name}) ${zig_type(field)} {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return ${default_value(field)};
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return ${default_value(field)};
         return ${runtime_getter(field)}(self._msg, field_desc, ${default_value(field)});
     }
 
     pub fn set${pascal_case(field.name)}(self: *${message.name}, value: ${zig_type(field)}) void {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return;
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return;
         ${runtime_setter(field)}(self._msg, field_desc, value);
     }
 % elif is_enum(field):
     pub fn get${pascal_case(field.name)}(self: *const ${message.name}) ${zig_type(field)} {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return @enumFromInt(0);
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return @enumFromInt(0);
         const raw = upb_zig.getInt32(self._msg, field_desc, 0);
         return ${zig_type(field)}.fromInt(raw) orelse @enumFromInt(0);
     }
 
     pub fn set${pascal_case(field.name)}(self: *${message.name}, value: ${zig_type(field)}) void {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return;
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return;
         upb_zig.setInt32(self._msg, field_desc, value.toInt());
     }
 % else:
     pub fn get${pascal_case(field.name)}(self: *const ${message.name}) ?${zig_type(field)} {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return null;
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return null;
         const sub_msg = upb_zig.getMessage(self._msg, field_desc) orelse return null;
         return ${zig_type(field)}{ ._msg = sub_msg, ._arena = self._arena };
     }
 
-    pub fn set${pascal_case(field.name)}(self: *${message.name}, value: ${zig_type(field)}) void {
-        const field_desc = getField(FieldNumber.${escape_zig_keyword(field.name)}) orelse return;
-        upb_zig.setMessage(self._msg, field_desc, value._msg);
+    /// Sets `value`, fusing its arena into this message's arena if they
+    /// differ. Fails with error.ArenaFuseFailed if either arena was created
+    /// with initWithBuffer; clone() `value` into this message's arena first
+    /// in that case.
+    pub fn set${pascal_case(field.name)}(self: *${message.name}, value: ${zig_type(field)}) !void {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        const sub_msg = try upb_zig.adoptMessage(self._arena, value._arena, value._msg);
+        upb_zig.setMessage(self._msg, field_desc, sub_msg);
+    }
+
+    /// Get ${field.name} for in-place modification, setting it to a new empty
+    /// message in this message's arena if it is not set.
+    pub fn mutable${pascal_case(field.name)}(self: *${message.name}) !${zig_type(field)} {
+        const field_desc = fieldAt(FieldIndex.${escape_zig_keyword(field.name)}) orelse return error.OutOfMemory;
+        const mt = minitable orelse return error.OutOfMemory;
+        const sub_msg = try upb_zig.getOrCreateMessage(self._msg, mt, field_desc, self._arena);
+        return ${zig_type(field)}{ ._msg = sub_msg, ._arena = self._arena };
     }
 % endif
 
 % endfor
     /// Serialize this message to wire format bytes.
     pub fn encode(self: *const ${message.name}) upb_zig.EncodeError![]const u8 {
-        ensureInit();
+        return self.encodeWithOptions(.{});
+    }
+
+    /// Serialize this message to wire format bytes with explicit options,
+    /// e.g. `.deterministic` for bytes that can serve as a cache key.
+    pub fn encodeWithOptions(self: *const ${message.name}, options: upb_zig.EncodeOptions) upb_zig.EncodeError![]const u8 {
+        checkInit();
+        const mt = minitable orelse return error.EncodeFailed;
+        return upb_zig.encodeWithOptions(self._msg, mt, self._arena, options);
+    }
+
+    /// Serialize this message into `arena` instead of its own, e.g. a
+    /// scratch arena that is reset once the bytes have been sent, so
+    /// repeated encodes don't grow this message's arena.
+    pub fn encodeIn(self: *const ${message.name}, arena: upb_zig.Arena, options: upb_zig.EncodeOptions) upb_zig.EncodeError![]const u8 {
+        checkInit();
+        const mt = minitable orelse return error.EncodeFailed;
+        return upb_zig.encodeWithOptions(self._msg, mt, arena, options);
+    }
+
+    /// Stream this message to `writer` in wire format, writing top-level
+    /// repeated message, string and bytes fields one element at a time and
+    /// after the other fields, so the bytes differ from encode() in order.
+    /// Encodes through `scratch`, which is reset as it goes (see
+    /// upb_zig.encodeTo).
+    pub fn encodeTo(self: *const ${message.name}, scratch: *upb_zig.Arena, writer: *std.Io.Writer) upb_zig.EncodeToError!void {
+        std.debug.assert(scratch.ptr != self._arena.ptr);
+        checkInit();
         const mt = minitable orelse return error.EncodeFailed;
-        return upb_zig.encode(self._msg, mt, self._arena);
+        return upb_zig.encodeTo(self._msg, mt, scratch, writer);
     }
 
     /// Parse wire format bytes into a new message.
     pub fn decode(arena: upb_zig.Arena, data: []const u8) upb_zig.DecodeError!${message.name} {
-        ensureInit();
+        return decodeWithOptions(arena, data, .{});
+    }
+
+    /// Parse wire format bytes into a new message with explicit options.
+    /// With `alias_string`, string and bytes fields point into `data`
+    /// instead of being copied, so `data` must outlive `arena`.
+    pub fn decodeWithOptions(arena: upb_zig.Arena, data: []const u8, options: upb_zig.DecodeOptions) upb_zig.DecodeError!${message.name} {
+        checkInit();
         const mt = minitable orelse return error.DecodeFailed;
         const msg = upb_zig.messageNew(mt, arena) orelse return error.DecodeFailed;
-        try upb_zig.decode(msg, mt, data, arena);
+        try upb_zig.decodeWithOptions(msg, mt, data, arena, options);
         return ${message.name}{
             ._msg = msg,
             ._arena = arena,
         };
     }
 
+    /// Parse wire format bytes into this message, merging with what it
+    /// already holds: set scalars are overwritten, repeated fields appended
+    /// and sub-messages merged. Replaced data stays in the arena until it
+    /// is freed or reset.
+    pub fn mergeFrom(self: *${message.name}, data: []const u8) upb_zig.DecodeError!void {
+        return self.mergeFromWithOptions(data, .{});
+    }
+
+    /// mergeFrom() with explicit decode options.
+    pub fn mergeFromWithOptions(self: *${message.name}, data: []const u8, options: upb_zig.DecodeOptions) upb_zig.DecodeError!void {
+        checkInit();
+        const mt = minitable orelse return error.DecodeFailed;
+        try upb_zig.decodeWithOptions(self._msg, mt, data, self._arena, options);
+    }
+
     /// Serialize this message to JSON format.
     pub fn encodeJson(self: *const ${message.name}, options: upb_zig.JsonEncodeOptions) upb_zig.JsonEncodeError![]const u8 {
-        ensureInit();
+        checkInit();
+        ensureJsonInit();
         const md = msgdef orelse return error.JsonEncodeFailed;
         const pool = upb_zig.sharedDefPool() catch return error.JsonEncodeFailed;
         return upb_zig.jsonEncode(self._msg, md, pool, self._arena, options);
@@ -289,7 +570,8 @@ pub const ${message.name} = struct {
 
     /// Parse JSON into a new message.
     pub fn decodeJson(arena: upb_zig.Arena, json_data: []const u8, options: upb_zig.JsonDecodeOptions) upb_zig.JsonDecodeError!${message.name} {
-        ensureInit();
+        checkInit();
+        ensureJsonInit();
         const mt = minitable orelse return error.JsonDecodeFailed;
         const md = msgdef orelse return error.JsonDecodeFailed;
         const pool = upb_zig.sharedDefPool() catch return error.JsonDecodeFailed;
@@ -303,7 +585,7 @@ pub const ${message.name} = struct {
 
     /// Create a new empty message.
     pub fn init(arena: upb_zig.Arena) !${message.name} {
-        ensureInit();
+        checkInit();
         const mt = minitable orelse return error.OutOfMemory;
         const msg = upb_zig.messageNew(mt, arena) orelse return error.OutOfMemory;
         return ${message.name}{
@@ -311,6 +593,17 @@ pub const ${message.name} = struct {
             ._arena = arena,
         };
     }
+
+    /// Deep-copy this message into `arena`.
+    pub fn clone(self: *const ${message.name}, arena: upb_zig.Arena) !${message.name} {
+        checkInit();
+        const mt = minitable orelse return error.OutOfMemory;
+        const msg = try upb_zig.cloneMessage(self._msg, mt, arena);
+        return ${message.name}{
+            ._msg = msg,
+            ._arena = arena,
+        };
+    }
 };
 ''')
 
@@ -326,27 +619,6 @@ def serialize_to_zig_bytes(data: bytes) -> str:
     return '"' + ''.join(parts) + '"'
 
 
-def get_message_full_names(file_desc: FileDescriptorProto) -> List[str]:
-    """Get all fully-qualified message names in a file.
-
-    Returns names like "package.MessageName" or "package.Outer.Nested".
-    """
-    names: list[str] = []
-    package = file_desc.package
-
-    def collect_messages(msg: DescriptorProto, prefix: str):
-        full_name = f"{prefix}.{msg.name}" if prefix else msg.name
-        names.append(full_name)
-        for nested in msg.nested_type:
-            collect_messages(nested, full_name)
-
-    prefix = package if package else ""
-    for msg in file_desc.message_type:
-        collect_messages(msg, prefix)
-
-    return names
-
-
 def proto_to_module_name(file_desc: FileDescriptorProto) -> str:
     """Convert a proto file to its Zig module name.
 
@@ -468,6 +740,11 @@ def is_scalar(field: FieldDescriptorProto) -> bool:
     return field.type in PROTO_TYPE_TO_RUNTIME_FN
 
 
+def is_packable(field: FieldDescriptorProto) -> bool:
+    """Check if a field is a numeric or bool scalar (stored unboxed in upb arrays)."""
+    return is_scalar(field) and field.type not in (FieldDescriptorProto.TYPE_STRING, FieldDescriptorProto.TYPE_BYTES)
+
+
 def is_enum(field: FieldDescriptorProto) -> bool:
     """Check if a field is an enum type."""
     return field.type == FieldDescriptorProto.TYPE_ENUM
@@ -496,8 +773,18 @@ def generate_enum(enum: EnumDescriptorProto, file_name: str) -> str:
     )
 
 
-def generate_message(message: DescriptorProto, file_name: str, resolve_type: None = None, parent_fqn: str = "") -> str:
-    """Generate Zig code for a message."""
+def indent(code: str, prefix: str = "    ") -> str:
+    """Indent every non-empty line of `code`."""
+    return "\n".join(prefix + line if line else line for line in code.rstrip("\n").split("\n"))
+
+
+def generate_message(message: DescriptorProto, file_name: str, table_index: int, resolve_type: None = None, parent_fqn: str = "", table_index_of: Optional[Callable[[str], int]] = None) -> str:
+    """Generate Zig code for a message.
+
+    Nested messages (other than map entries) are generated as full structs
+    inside their parent; table_index_of maps their package-relative name to
+    their position in the file's MiniTable arrays.
+    """
     # Build the fully qualified name for this message
     if parent_fqn:
         message_fqn = f"{parent_fqn}.{message.name}"
@@ -532,6 +819,31 @@ def generate_message(message: DescriptorProto, file_name: str, resolve_type: Non
         else:
             return PROTO_TYPE_TO_ZIG.get(field.type, "anyopaque")
 
+    # Map fields are repeated fields of a synthesized nested *Entry message
+    # (key = field 1, value = field 2).
+    map_entries = {m.name: m for m in message.nested_type if m.options.map_entry}
+
+    def map_info(field: FieldDescriptorProto) -> Optional[Dict[str, str]]:
+        if not is_repeated(field) or field.type != FieldDescriptorProto.TYPE_MESSAGE:
+            return None
+        entry = map_entries.get(field.type_name.split('.')[-1])
+        if entry is None:
+            return None
+        key_field = next(f for f in entry.field if f.number == 1)
+        value_field = next(f for f in entry.field if f.number == 2)
+        if is_scalar(value_field):
+            kind, raw = "scalar", zig_type_resolved(value_field)
+        elif is_enum(value_field):
+            kind, raw = "enum", "i32"
+        else:
+            kind, raw = "message", "*upb_zig.upb_Message"
+        return {
+            "key": zig_type_resolved(key_field),
+            "value": zig_type_resolved(value_field),
+            "raw": raw,
+            "kind": kind,
+        }
+
     # Collect oneofs (skip proto3 synthetic oneofs for optional fields)
     oneofs = []
     for i, oneof in enumerate(message.oneof_decl):
@@ -542,9 +854,20 @@ def generate_message(message: DescriptorProto, file_name: str, resolve_type: Non
         if oneof_fields:
             oneofs.append((oneof.name, oneof_fields))
 
-    return MESSAGE_TEMPLATE.render(
+    nested_messages = []
+    if table_index_of:
+        for nested_msg in message.nested_type:
+            if nested_msg.options.map_entry:
+                continue
+            nested_fqn = f"{message_fqn}.{nested_msg.name}"
+            nested_code = generate_message(nested_msg, file_name, table_index_of(nested_fqn), resolve_type, message_fqn, table_index_of)
+            nested_messages.append(indent(nested_code))
+
+    code = MESSAGE_TEMPLATE.render(
         message=message,
         file_name=file_name,
+        table_index=table_index,
+        nested_messages=nested_messages,
         len=len,
         snake_to_camel=snake_to_camel,
         pascal_case=pascal_case,
@@ -552,7 +875,9 @@ def generate_message(message: DescriptorProto, file_name: str, resolve_type: Non
         field_type_name=field_type_name,
         is_repeated=is_repeated,
         is_scalar=is_scalar,
+        is_packable=is_packable,
         is_enum=is_enum,
+        map_info=map_info,
         default_return=default_return,
         default_value=default_value,
         runtime_getter=runtime_getter,
@@ -562,6 +887,33 @@ def generate_message(message: DescriptorProto, file_name: str, resolve_type: Non
         escape_zig_keyword=escape_zig_keyword,
         oneofs=oneofs,
     )
+    check_unique_declarations(code, message, message_fqn)
+    return code
+
+
+# A declaration directly inside a generated message struct (nested types
+# are indented further).
+MESSAGE_DECL_RE = re.compile(r"^    (?:pub )?(?:inline )?(?:fn|const|var) (@\"[^\"]+\"|\w+)", re.MULTILINE)
+
+
+def check_unique_declarations(code: str, message: DescriptorProto, message_fqn: str):
+    """Fail generation if two accessors of a message get the same name.
+
+    Accessor names are built from field names (e.g. repeated `foo` gets
+    setAllFoo, getFooSlice and addNewFoo), so a field named `all_foo`,
+    `foo_slice` or `new_foo` can collide with them, which Zig would reject
+    as a duplicate declaration in the generated file.
+    """
+    seen = set()
+    for name in MESSAGE_DECL_RE.findall(code):
+        if name not in seen:
+            seen.add(name)
+            continue
+        fields = [f.name for f in message.field
+                  if pascal_case(f.name) in name or snake_to_camel(f.name) in name]
+        raise ValueError(
+            f"message {message_fqn}: more than one declaration named '{name}' would be "
+            f"generated (from fields {', '.join(fields) or 'unknown'}); rename one of the fields")
 
 
 def find_type_file(type_name: str, file_map: Dict[str, FileDescriptorProto]) -> Optional[FileDescriptorProto]:
@@ -615,19 +967,35 @@ def collect_external_types(file_desc: FileDescriptorProto, file_map: Dict[str, F
     return external_types
 
 
-def generate_file(file_desc: FileDescriptorProto, file_map: Dict[str, FileDescriptorProto]) -> str:
-    """Generate a complete Zig file from a FileDescriptorProto."""
+def generate_file(file_desc: FileDescriptorProto, file_map: Dict[str, FileDescriptorProto], minitable_mode: str = "eager") -> str:
+    """Generate a complete Zig file from a FileDescriptorProto.
+
+    minitable_mode selects the default upb_zig.MiniTableMode for the file.
+    """
+    if minitable_mode not in MINITABLE_MODES:
+        raise ValueError(f"unknown minitable_mode: {minitable_mode}")
     # Collect external type references
     external_types = collect_external_types(file_desc, file_map)
 
     # Get unique module names needed
-    modules_needed = sorted(set(external_types.values()))
+    # Every import is needed, not just the ones whose types are referenced:
+    # _json_init() and warmUp() initialize dependencies first.
+    dep_modules = [proto_to_module_name(file_map[dep]) for dep in file_desc.dependency if dep in file_map]
+    modules_needed = sorted(set(external_types.values()) | set(dep_modules))
 
     # Generate import statements
     imports = ["const std = @import(\"std\");", "const upb_zig = @import(\"upb_zig\");"]
     for module in modules_needed:
         imports.append(f'pub const {module} = @import("{module}");')
 
+    # Maps full name to Zig struct path
+    def full_name_to_zig_path(full_name: str) -> str:
+        """Convert package.Outer.Inner to Outer.Inner (Zig path)."""
+        pkg = file_desc.package
+        if pkg and full_name.startswith(pkg + "."):
+            return full_name[len(pkg) + 1:]
+        return full_name
+
     # Create a type resolver that qualifies external types
     def resolve_type(type_name: str) -> str:
         """Resolve a type name, qualifying with module if external."""
@@ -636,51 +1004,90 @@ def generate_file(file_desc: FileDescriptorProto, file_map: Dict[str, FileDescri
             simple_name = type_name.split('.')[-1]
             return f"{module}.{simple_name}"
         else:
-            return type_name.split('.')[-1]
+            return full_name_to_zig_path(type_name[1:])
+
+    # Encode a MiniDescriptor for every message and closed enum in the file
+    type_index = TypeIndex(file_map)
+    message_names = type_index.message_order[file_desc.name]
+    enum_names = type_index.enum_order[file_desc.name]
+
+    def table_index_of(zig_path: str) -> int:
+        """Position of a message, by package-relative name, in this file's MiniTable arrays."""
+        prefix = f".{file_desc.package}" if file_desc.package else ""
+        return message_names.index(f"{prefix}.{zig_path}")
 
     enums_code = [generate_enum(e, file_desc.name) for e in file_desc.enum_type]
-    messages_code = [generate_message(m, file_desc.name, resolve_type) for m in file_desc.message_type]
+    messages_code = [generate_message(m, file_desc.name, table_index_of(m.name), resolve_type, table_index_of=table_index_of) for m in file_desc.message_type]
 
-    # Serialize the FileDescriptorProto for embedding
+    # Serialize the FileDescriptorProto for embedding (JSON and def_pool mode only)
     serialized = file_desc.SerializeToString()
     zig_bytes = serialize_to_zig_bytes(serialized)
 
-    # Get all message full names for initialization
-    message_full_names = get_message_full_names(file_desc)
-
-    # Build the message initialization list
-    # Maps full name to Zig struct path
-    def full_name_to_zig_path(full_name: str) -> str:
-        """Convert package.Outer.Inner to Outer.Inner (Zig path)."""
-        pkg = file_desc.package
-        if pkg and full_name.startswith(pkg + "."):
-            return full_name[len(pkg) + 1:]
-        return full_name
-
-    # Generate dependency initialization calls
-    dep_init_lines = []
-    for dep in file_desc.dependency:
-        if dep in file_map:
-            dep_module = proto_to_module_name(file_map[dep])
-            dep_init_lines.append(f'    {dep_module}._file_init();')
-
-    # Generate initialization code for each top-level message (nested are handled separately)
-    init_lines = []
-    for full_name in message_full_names:
-        zig_path = full_name_to_zig_path(full_name)
-        # Only initialize top-level messages directly; nested ones need special handling
-        if "." not in zig_path:
-            init_lines.append(f'    if (pool.findMessage("{full_name}")) |msg_def| {{')
-            init_lines.append(f'        {zig_path}.msgdef = msg_def;')
-            init_lines.append(f'        {zig_path}.minitable = upb_zig.getMessageMiniTable(msg_def);')
-            init_lines.append(f'    }}')
-
-    # Build dependency init section
-    dep_init_section = ""
-    if dep_init_lines:
-        dep_init_section = f'''
-    // Initialize dependencies first (they add their descriptors to the shared pool)
-{chr(10).join(dep_init_lines)}
+    def table_ref(owner_file: str, index: int, getter: str) -> str:
+        """Call a MiniTable getter, qualified with the module if external."""
+        if owner_file == file_desc.name:
+            return f"{getter}({index})"
+        return f"{proto_to_module_name(file_map[owner_file])}.{getter}({index})"
+
+    message_descriptor_lines = []
+    message_name_lines = []
+    for full_name in message_names:
+        message_descriptor_lines.append(f'    "{type_index.encode_message(full_name)}", // {full_name[1:]}')
+        message_name_lines.append(f'    "{full_name[1:]}",')
+
+    enum_descriptor_lines = []
+    enum_name_lines = []
+    for full_name in enum_names:
+        encoded = type_index.encode_enum(full_name) if type_index.enums[full_name].closed else ""
+        enum_descriptor_lines.append(f'    "{encoded}", // {full_name[1:]}')
+        enum_name_lines.append(f'    "{full_name[1:]}",')
+
+    # Link step for each message. Same-file sub-messages go through
+    # _buildMessage so eager initialization can recurse inside _file_init().
+    link_lines = []
+    for i, full_name in enumerate(message_names):
+        subs = []
+        for t in type_index.sub_messages(full_name):
+            owner, j = type_index.message_index(t)
+            getter = "_buildMessage" if owner == file_desc.name else "_messageMiniTable"
+            subs.append(table_ref(owner, j, getter))
+        enums = [table_ref(*type_index.enum_index(t), "_enumMiniTable") for t in type_index.sub_enums(full_name)]
+        if not subs and not enums:
+            continue
+        link_lines.append(f'        {i} => {{')
+        link_lines.append(f'            const subs = [_]?*const upb_zig.upb_MiniTable{{ {", ".join(subs)} }};')
+        link_lines.append(f'            const enums = [_]?*const upb_zig.upb_MiniTableEnum{{ {", ".join(enums)} }};')
+        link_lines.append(f'            return upb_zig.linkMiniTable(mt, &subs, &enums);')
+        link_lines.append(f'        }},')
+
+    if link_lines:
+        link_body = "    switch (index) {\n" + "\n".join(link_lines) + "\n        else => return true,\n    }"
+    else:
+        link_body = "    _ = index;\n    _ = mt;\n    return true;"
+
+    # Generate dependency initialization calls (the DefPool resolves imports by name)
+    dep_json_init_lines = [f'    {m}._json_init();' for m in dep_modules]
+    dep_warm_up_lines = [f'    {m}.warmUp(options);' for m in dep_modules]
+
+    # Every generated message struct; map entries have none.
+    struct_names = [(i, full_name_to_zig_path(full_name[1:])) for i, full_name in enumerate(message_names)
+                    if not type_index.messages[full_name].desc.options.map_entry]
+
+    # Publish MessageDefs for each generated message
+    json_init_lines = []
+    for i, zig_path in struct_names:
+        json_init_lines.append(f'    if (pool.findMessage(_message_full_names[{i}])) |msg_def| {{')
+        json_init_lines.append(f'        @atomicStore(?*const upb_zig.upb_MessageDef, &{zig_path}.msgdef, msg_def, .release);')
+        json_init_lines.append(f'    }}')
+
+    warm_up_deps = chr(10).join(dep_warm_up_lines)
+    warm_up_messages = chr(10).join(f'    {zig_path}.ensureInit();' for _, zig_path in struct_names)
+
+    dep_json_init_section = ""
+    if dep_json_init_lines:
+        dep_json_init_section = f'''
+    // Load dependencies first (the DefPool resolves imports by name)
+{chr(10).join(dep_json_init_lines)}
 '''
 
     header = f'''//! Generated by protoc-gen-zig from {file_desc.name}
@@ -691,28 +1098,152 @@ def generate_file(file_desc: FileDescriptorProto, file_map: Dict[str, FileDescri
 
 {chr(10).join(imports)}
 
+/// How this file builds its MiniTables. Assign before the first message from
+/// this file is used to compare startup cost between modes. Tables built
+/// either way have identical layouts, so files using different modes mix.
+pub var minitable_mode: upb_zig.MiniTableMode = .{minitable_mode};
+
 // Embedded serialized FileDescriptorProto for this file.
-// Used to initialize MiniTables at runtime via upb reflection.
+// Loaded into the shared DefPool for JSON, and for def_pool mode.
 const _file_descriptor_bytes = {zig_bytes};
 
+/// MiniDescriptors for every message in this file (nested messages follow
+/// their parent), encoded by protoc-gen-zig. Public so tests can compare
+/// them with upb's own encoder.
+pub const _message_mini_descriptors = [_][]const u8{{
+{chr(10).join(message_descriptor_lines)}
+}};
+
+/// Full names of the messages above, for DefPool lookups.
+pub const _message_full_names = [_][:0]const u8{{
+{chr(10).join(message_name_lines)}
+}};
+
+/// MiniDescriptors for every enum in this file; empty for open enums, which
+/// need no MiniTableEnum.
+pub const _enum_mini_descriptors = [_][]const u8{{
+{chr(10).join(enum_descriptor_lines)}
+}};
+
+/// Full names of the enums above, for DefPool lookups.
+pub const _enum_full_names = [_][:0]const u8{{
+{chr(10).join(enum_name_lines)}
+}};
+
+/// MiniTables for every message in this file, indexed like _message_mini_descriptors.
+pub var _minitables: [{len(message_names)}]?*const upb_zig.upb_MiniTable = .{{null}} ** {len(message_names)};
+
+/// MiniTableEnums for the closed enums in this file, indexed like _enum_mini_descriptors.
+pub var _enum_minitables: [{len(enum_names)}]?*const upb_zig.upb_MiniTableEnum = .{{null}} ** {len(enum_names)};
+
 // Initialization state
 var _init_done: bool = false;
+var _json_init_done: bool = false;
+var _warm_up_done: bool = false;
+
+// Everything below runs under upb_zig.lockInit(); generated messages only
+// call into it the first time they are used.
+
+/// Get the MiniTable for the message at `index`, building it as selected by
+/// minitable_mode. This function is public so dependents can link against it.
+pub fn _messageMiniTable(index: usize) ?*const upb_zig.upb_MiniTable {{
+    upb_zig.lockInit();
+    defer upb_zig.unlockInit();
+    if (_minitables[index]) |mt| return mt;
+    switch (minitable_mode) {{
+        .lazy => return _buildMessage(index),
+        .eager, .def_pool => {{
+            _file_init();
+            return _minitables[index];
+        }},
+    }}
+}}
 
-/// Initialize all message MiniTables from the embedded descriptor.
+/// Get the MiniTableEnum for the closed enum at `index`, building it on first use.
+/// This function is public so dependents can link against it.
+pub fn _enumMiniTable(index: usize) ?*const upb_zig.upb_MiniTableEnum {{
+    upb_zig.lockInit();
+    defer upb_zig.unlockInit();
+    if (_enum_minitables[index]) |e| return e;
+    const desc = _enum_mini_descriptors[index];
+    if (desc.len == 0) return null;
+    _enum_minitables[index] = upb_zig.buildMiniTableEnum(desc);
+    return _enum_minitables[index];
+}}
+
+/// Build one message's MiniTable and link the tables it references.
+/// The table is stored before linking so recursive message types terminate.
+fn _buildMessage(index: usize) ?*const upb_zig.upb_MiniTable {{
+    if (_minitables[index]) |mt| return mt;
+    const mt = upb_zig.buildMiniTable(_message_mini_descriptors[index]) orelse return null;
+    _minitables[index] = mt;
+    if (!_linkMessage(index, mt)) _minitables[index] = null;
+    return _minitables[index];
+}}
+
+/// Link sub-message and closed enum fields of the message at `index`.
+fn _linkMessage(index: usize, mt: *upb_zig.upb_MiniTable) bool {{
+{link_body}
+}}
+
+/// Build the MiniTables for every message in this file (eager and def_pool modes).
 /// Called automatically on first use of any message in this file.
-/// This function is public so dependencies can call it.
+/// This function is public so dependents can call it.
 pub fn _file_init() void {{
+    upb_zig.lockInit();
+    defer upb_zig.unlockInit();
     if (_init_done) return;
     _init_done = true;
-{dep_init_section}
+
+    if (minitable_mode == .def_pool) {{
+        // Take every MiniTable from its MessageDef in the shared DefPool
+        _json_init();
+        const pool = upb_zig.sharedDefPool() catch return;
+        for (_message_full_names, 0..) |name, i| {{
+            if (pool.findMessage(name)) |msg_def| _minitables[i] = upb_zig.getMessageMiniTable(msg_def);
+        }}
+        return;
+    }}
+
+    for (0.._message_mini_descriptors.len) |i| {{
+        _ = _buildMessage(i);
+    }}
+}}
+
+/// Initialize every message in this file and in the files it imports, in any
+/// minitable_mode, so that no message pays for initialization on first use.
+/// See upb_zig.warmUpAll().
+pub fn warmUp(options: upb_zig.WarmUpOptions) void {{
+    upb_zig.lockInit();
+    defer upb_zig.unlockInit();
+{warm_up_deps}
+    for (0.._message_mini_descriptors.len) |i| {{
+        _ = _messageMiniTable(i);
+    }}
+{warm_up_messages}
+    if (options.json) _json_init();
+    if (!_warm_up_done) {{
+        _warm_up_done = true;
+        upb_zig.noteFileWarmedUp();
+    }}
+}}
+
+/// Load this file's descriptor into the shared DefPool for JSON support.
+/// This function is public so dependencies can call it.
+pub fn _json_init() void {{
+    upb_zig.lockInit();
+    defer upb_zig.unlockInit();
+    if (_json_init_done) return;
+    _json_init_done = true;
+{dep_json_init_section}
     // Get the shared DefPool and load this file's descriptor
     const pool = upb_zig.sharedDefPool() catch return;
     pool.addFile(_file_descriptor_bytes);
 
-    // Initialize MiniTables for all messages
-{chr(10).join(init_lines)}
+    // Look up MessageDefs for all messages
+{chr(10).join(json_init_lines)}
 }}
 
 '''
 
-    return header + "\n".join(enums_code) + "\n" + "\n".join(messages_code)
\ No newline at end of file
+    return header + "\n".join(enums_code) + "\n" + "\n".join(messages_code)
@@ -0,0 +1,441 @@
+"""
+MiniDescriptor encoding for upb_zig.
+
+Encodes messages and enums into upb's compact MiniDescriptor format at code
+generation time, mirroring upb/mini_descriptor/internal/encode.c and the
+feature resolution done by upb's reflection (upb/reflection/*_def.c). The
+generated code hands these strings to upb_MiniTable_Build() so the wire
+encode/decode path never needs a DefPool.
+"""
+
+from google.protobuf.descriptor_pb2 import ( # pyright: ignore[reportMissingModuleSource]
+    FileDescriptorProto,
+    DescriptorProto,
+    FieldDescriptorProto,
+    EnumDescriptorProto,
+    FeatureSet,
+)
+from typing import Dict, List, Tuple
+
+# -------------- CONSTANTS --------------
+# Base92 alphabet: printable ASCII minus '"', '\'' and '\\'.
+BASE92 = (
+    " !#$%&()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[]^_`"
+    "abcdefghijklmnopqrstuvwxyz{|}~"
+)
+
+# Version prefixes (kUpb_EncodedVersion_*)
+VERSION_ENUM = "!"
+VERSION_MAP = "%"
+VERSION_MESSAGE = "$"
+VERSION_MESSAGE_SET = "&"
+
+# Value ranges (kUpb_EncodedValue_*)
+MIN_MODIFIER, MAX_MODIFIER = "L", "["
+END = "^"
+MIN_SKIP, MAX_SKIP = "_", "~"
+ONEOF_SEPARATOR = "~"
+FIELD_SEPARATOR = "|"
+MIN_ONEOF_FIELD, MAX_ONEOF_FIELD = " ", "b"
+
+# Encoded field types (kUpb_EncodedType_*)
+ENCODED_TYPE = {
+    FieldDescriptorProto.TYPE_DOUBLE: 0,
+    FieldDescriptorProto.TYPE_FLOAT: 1,
+    FieldDescriptorProto.TYPE_FIXED32: 2,
+    FieldDescriptorProto.TYPE_FIXED64: 3,
+    FieldDescriptorProto.TYPE_SFIXED32: 4,
+    FieldDescriptorProto.TYPE_SFIXED64: 5,
+    FieldDescriptorProto.TYPE_INT32: 6,
+    FieldDescriptorProto.TYPE_UINT32: 7,
+    FieldDescriptorProto.TYPE_SINT32: 8,
+    FieldDescriptorProto.TYPE_INT64: 9,
+    FieldDescriptorProto.TYPE_UINT64: 10,
+    FieldDescriptorProto.TYPE_SINT64: 11,
+    FieldDescriptorProto.TYPE_ENUM: 12,  # open enum
+    FieldDescriptorProto.TYPE_BOOL: 13,
+    FieldDescriptorProto.TYPE_BYTES: 14,
+    FieldDescriptorProto.TYPE_STRING: 15,
+    FieldDescriptorProto.TYPE_GROUP: 16,
+    FieldDescriptorProto.TYPE_MESSAGE: 17,
+}
+ENCODED_TYPE_CLOSED_ENUM = 18
+ENCODED_TYPE_REPEATED_BASE = 20
+
+# Encoded field modifiers (kUpb_EncodedFieldModifier_*)
+ENCODED_FLIP_PACKED = 1 << 0
+ENCODED_IS_REQUIRED = 1 << 1
+ENCODED_IS_PROTO3_SINGULAR = 1 << 2
+ENCODED_FLIP_VALIDATE_UTF8 = 1 << 3
+
+# Field modifiers (kUpb_FieldModifier_*)
+FIELD_IS_REPEATED = 1 << 0
+FIELD_IS_PACKED = 1 << 1
+FIELD_IS_CLOSED_ENUM = 1 << 2
+FIELD_IS_PROTO3_SINGULAR = 1 << 3
+FIELD_IS_REQUIRED = 1 << 4
+FIELD_VALIDATE_UTF8 = 1 << 5
+
+# Message modifiers (kUpb_MessageModifier_*)
+MESSAGE_VALIDATE_UTF8 = 1 << 0
+MESSAGE_DEFAULT_IS_PACKED = 1 << 1
+MESSAGE_IS_EXTENDABLE = 1 << 2
+
+# Field types that cannot be packed
+UNPACKABLE_TYPES = {
+    FieldDescriptorProto.TYPE_STRING,
+    FieldDescriptorProto.TYPE_BYTES,
+    FieldDescriptorProto.TYPE_MESSAGE,
+    FieldDescriptorProto.TYPE_GROUP,
+}
+
+# Edition defaults for the features that affect MiniTable layout
+EDITION_DEFAULTS = {
+    "proto2": {
+        "field_presence": FeatureSet.EXPLICIT,
+        "enum_type": FeatureSet.CLOSED,
+        "repeated_field_encoding": FeatureSet.EXPANDED,
+        "utf8_validation": FeatureSet.NONE,
+        "message_encoding": FeatureSet.LENGTH_PREFIXED,
+    },
+    "proto3": {
+        "field_presence": FeatureSet.IMPLICIT,
+        "enum_type": FeatureSet.OPEN,
+        "repeated_field_encoding": FeatureSet.PACKED,
+        "utf8_validation": FeatureSet.VERIFY,
+        "message_encoding": FeatureSet.LENGTH_PREFIXED,
+    },
+    "editions": {
+        "field_presence": FeatureSet.EXPLICIT,
+        "enum_type": FeatureSet.OPEN,
+        "repeated_field_encoding": FeatureSet.PACKED,
+        "utf8_validation": FeatureSet.VERIFY,
+        "message_encoding": FeatureSet.LENGTH_PREFIXED,
+    },
+}
+
+
+def file_syntax(file_desc: FileDescriptorProto) -> str:
+    """Return "proto2", "proto3" or "editions" for a file."""
+    if file_desc.syntax in ("", "proto2"):
+        return "proto2"
+    return file_desc.syntax
+
+
+def resolve_features(parent: Dict[str, int], options) -> Dict[str, int]:
+    """Overlay the features set in `options` on top of the parent features."""
+    if not options.HasField("features"):
+        return parent
+    resolved = dict(parent)
+    for name in resolved:
+        if options.features.HasField(name):
+            resolved[name] = getattr(options.features, name)
+    return resolved
+
+
+class _Base92Writer:
+    """Accumulates a MiniDescriptor string (upb_MtDataEncoder)."""
+
+    def __init__(self):
+        self.chars: List[str] = []
+
+    def put_raw(self, ch: str):
+        self.chars.append(ch)
+
+    def put(self, value: int):
+        self.chars.append(BASE92[value])
+
+    def put_varint(self, value: int, min_ch: str, max_ch: str):
+        lo, hi = BASE92.index(min_ch), BASE92.index(max_ch)
+        shift = (hi - lo).bit_length()  # log2ceil(hi - lo + 1)
+        mask = (1 << shift) - 1
+        while True:
+            self.put((value & mask) + lo)
+            value >>= shift
+            if not value:
+                break
+
+    def put_modifier(self, mod: int):
+        if mod:
+            self.put_varint(mod, MIN_MODIFIER, MAX_MODIFIER)
+
+    def result(self) -> str:
+        return "".join(self.chars)
+
+
+class MessageInfo:
+    """A message plus the context needed to encode it."""
+
+    def __init__(self, desc: DescriptorProto, full_name: str, file_desc: FileDescriptorProto, features: Dict[str, int]):
+        self.desc = desc
+        self.full_name = full_name
+        self.file_desc = file_desc
+        self.features = features
+
+
+class EnumInfo:
+    """An enum plus its resolved closedness."""
+
+    def __init__(self, desc: EnumDescriptorProto, full_name: str, file_desc: FileDescriptorProto, closed: bool):
+        self.desc = desc
+        self.full_name = full_name
+        self.file_desc = file_desc
+        self.closed = closed
+
+
+class TypeIndex:
+    """Index of every message and enum across the files of a request.
+
+    Messages and enums are numbered per file in declaration order (nested types
+    follow their parent), which is also the order of the generated
+    _minitables / _enum_minitables arrays.
+    """
+
+    def __init__(self, file_map: Dict[str, FileDescriptorProto]):
+        self.messages: Dict[str, MessageInfo] = {}
+        self.enums: Dict[str, EnumInfo] = {}
+        self.message_order: Dict[str, List[str]] = {}
+        self.enum_order: Dict[str, List[str]] = {}
+        for file_desc in file_map.values():
+            self._index_file(file_desc)
+
+    def _index_file(self, file_desc: FileDescriptorProto):
+        syntax = file_syntax(file_desc)
+        file_features = resolve_features(EDITION_DEFAULTS[syntax], file_desc.options)
+        messages: List[str] = []
+        enums: List[str] = []
+        prefix = f".{file_desc.package}" if file_desc.package else ""
+
+        def add_enum(enum: EnumDescriptorProto, scope: str, features: Dict[str, int]):
+            full_name = f"{scope}.{enum.name}"
+            enum_features = resolve_features(features, enum.options)
+            closed = enum_features["enum_type"] == FeatureSet.CLOSED
+            self.enums[full_name] = EnumInfo(enum, full_name, file_desc, closed)
+            enums.append(full_name)
+
+        def add_message(msg: DescriptorProto, scope: str, features: Dict[str, int]):
+            full_name = f"{scope}.{msg.name}"
+            msg_features = resolve_features(features, msg.options)
+            self.messages[full_name] = MessageInfo(msg, full_name, file_desc, msg_features)
+            messages.append(full_name)
+            for nested in msg.nested_type:
+                add_message(nested, full_name, msg_features)
+
+        for enum in file_desc.enum_type:
+            add_enum(enum, prefix, file_features)
+        for msg in file_desc.message_type:
+            add_message(msg, prefix, file_features)
+        # Nested enums are numbered after all top-level enums
+        for full_name in list(messages):
+            info = self.messages[full_name]
+            for enum in info.desc.enum_type:
+                add_enum(enum, full_name, info.features)
+
+        self.message_order[file_desc.name] = messages
+        self.enum_order[file_desc.name] = enums
+
+    def message_index(self, full_name: str) -> Tuple[str, int]:
+        """Return (file name, index) for a fully-qualified message name."""
+        info = self.messages[full_name]
+        return info.file_desc.name, self.message_order[info.file_desc.name].index(full_name)
+
+    def enum_index(self, full_name: str) -> Tuple[str, int]:
+        """Return (file name, index) for a fully-qualified enum name."""
+        info = self.enums[full_name]
+        return info.file_desc.name, self.enum_order[info.file_desc.name].index(full_name)
+
+    # --- upb_FieldDef equivalents ---
+
+    def field_type(self, field: FieldDescriptorProto, features: Dict[str, int]) -> int:
+        """Descriptor type as upb sees it (delimited messages become groups)."""
+        if field.type == FieldDescriptorProto.TYPE_MESSAGE:
+            sub = self.messages.get(field.type_name)
+            is_map_entry = sub is not None and sub.desc.options.map_entry
+            if features["message_encoding"] == FeatureSet.DELIMITED and not is_map_entry:
+                return FieldDescriptorProto.TYPE_GROUP
+        return field.type
+
+    def is_sub_message(self, field: FieldDescriptorProto) -> bool:
+        return field.type in (FieldDescriptorProto.TYPE_MESSAGE, FieldDescriptorProto.TYPE_GROUP)
+
+    def is_closed_enum(self, field: FieldDescriptorProto) -> bool:
+        if field.type != FieldDescriptorProto.TYPE_ENUM:
+            return False
+        enum = self.enums.get(field.type_name)
+        return enum is not None and enum.closed
+
+    def field_modifiers(self, field: FieldDescriptorProto, msg: DescriptorProto, msg_features: Dict[str, int]) -> int:
+        """Mirror of _upb_FieldDef_Modifiers()."""
+        features = resolve_features(msg_features, field.options)
+        field_type = self.field_type(field, features)
+        repeated = field.label == FieldDescriptorProto.LABEL_REPEATED
+
+        out = 0
+        if repeated and field_type not in UNPACKABLE_TYPES:
+            packed = features["repeated_field_encoding"] == FeatureSet.PACKED
+            if field.options.HasField("packed"):
+                packed = field.options.packed
+            if packed:
+                out |= FIELD_IS_PACKED
+
+        if repeated:
+            out |= FIELD_IS_REPEATED
+        elif (field.label == FieldDescriptorProto.LABEL_REQUIRED
+              or features["field_presence"] == FeatureSet.LEGACY_REQUIRED):
+            out |= FIELD_IS_REQUIRED
+        elif not self._has_presence(field, field_type, features):
+            out |= FIELD_IS_PROTO3_SINGULAR
+
+        if self.is_closed_enum(field):
+            out |= FIELD_IS_CLOSED_ENUM
+        if self._validates_utf8(field_type, features):
+            out |= FIELD_VALIDATE_UTF8
+        return out
+
+    def _has_presence(self, field: FieldDescriptorProto, field_type: int, features: Dict[str, int]) -> bool:
+        if field_type in (FieldDescriptorProto.TYPE_MESSAGE, FieldDescriptorProto.TYPE_GROUP):
+            return True
+        if field.HasField("oneof_index") or field.proto3_optional:
+            return True
+        return features["field_presence"] != FeatureSet.IMPLICIT
+
+    def _validates_utf8(self, field_type: int, features: Dict[str, int]) -> bool:
+        return field_type == FieldDescriptorProto.TYPE_STRING and features["utf8_validation"] == FeatureSet.VERIFY
+
+    # --- Encoders ---
+
+    def encode_message(self, full_name: str) -> str:
+        """Mirror of upb_MessageDef_MiniDescriptorEncode()."""
+        info = self.messages[full_name]
+        msg = info.desc
+        if msg.options.map_entry:
+            return self._encode_map(info)
+        if msg.options.message_set_wire_format:
+            return VERSION_MESSAGE_SET
+
+        fields = sorted(msg.field, key=lambda f: f.number)
+        field_features = [resolve_features(info.features, f.options) for f in fields]
+        field_types = [self.field_type(f, ft) for f, ft in zip(fields, field_features)]
+
+        msg_mod = 0
+        if info.features["repeated_field_encoding"] == FeatureSet.PACKED:
+            msg_mod |= MESSAGE_DEFAULT_IS_PACKED
+        # Like _upb_MessageDef_ValidateUtf8(): only set for messages that have
+        # string fields, all of which validate.
+        string_utf8 = [self._validates_utf8(t, ft) for t, ft in zip(field_types, field_features)
+                       if t == FieldDescriptorProto.TYPE_STRING]
+        if string_utf8 and all(string_utf8):
+            msg_mod |= MESSAGE_VALIDATE_UTF8
+        if msg.extension_range:
+            msg_mod |= MESSAGE_IS_EXTENDABLE
+
+        w = _Base92Writer()
+        w.put_raw(VERSION_MESSAGE)
+        w.put_modifier(msg_mod)
+
+        last_number = 0
+        for field, field_type in zip(fields, field_types):
+            self._put_field(w, field_type, field.number, last_number,
+                            self.field_modifiers(field, msg, info.features), msg_mod)
+            last_number = field.number
+
+        # Real oneofs only; proto3 optional fields use synthetic oneofs
+        oneof_started = False
+        for oneof_index, _ in enumerate(msg.oneof_decl):
+            members = [f for f in msg.field
+                       if f.HasField("oneof_index") and f.oneof_index == oneof_index
+                       and not f.proto3_optional]
+            if not members:
+                continue
+            w.put_raw(ONEOF_SEPARATOR if oneof_started else END)
+            oneof_started = True
+            for i, member in enumerate(members):
+                if i:
+                    w.put_raw(FIELD_SEPARATOR)
+                w.put_varint(member.number, MIN_ONEOF_FIELD, MAX_ONEOF_FIELD)
+        return w.result()
+
+    def _encode_map(self, info: MessageInfo) -> str:
+        """Mirror of upb_MtDataEncoder_EncodeMap()."""
+        fields = sorted(info.desc.field, key=lambda f: f.number)
+        key, value = fields[0], fields[1]
+        w = _Base92Writer()
+        w.put_raw(VERSION_MAP)
+        last_number = 0
+        for field in (key, value):
+            features = resolve_features(info.features, field.options)
+            self._put_field(w, self.field_type(field, features), field.number, last_number,
+                            self.field_modifiers(field, info.desc, info.features), 0)
+            last_number = field.number
+        return w.result()
+
+    def _put_field(self, w: _Base92Writer, field_type: int, number: int, last_number: int,
+                   field_mod: int, msg_mod: int):
+        """Mirror of upb_MtDataEncoder_PutField()."""
+        if last_number + 1 != number:
+            w.put_varint(number - last_number, MIN_SKIP, MAX_SKIP)
+
+        encoded_mod = 0
+        encoded_type = ENCODED_TYPE[field_type]
+        if field_mod & FIELD_IS_CLOSED_ENUM:
+            encoded_type = ENCODED_TYPE_CLOSED_ENUM
+        if field_mod & FIELD_IS_REPEATED:
+            encoded_type += ENCODED_TYPE_REPEATED_BASE
+            if field_type not in UNPACKABLE_TYPES:
+                field_packed = bool(field_mod & FIELD_IS_PACKED)
+                default_packed = bool(msg_mod & MESSAGE_DEFAULT_IS_PACKED)
+                if field_packed != default_packed:
+                    encoded_mod |= ENCODED_FLIP_PACKED
+
+        if field_type == FieldDescriptorProto.TYPE_STRING:
+            field_utf8 = bool(field_mod & FIELD_VALIDATE_UTF8)
+            message_utf8 = bool(msg_mod & MESSAGE_VALIDATE_UTF8)
+            if field_utf8 != message_utf8:
+                encoded_mod |= ENCODED_FLIP_VALIDATE_UTF8
+
+        if field_mod & FIELD_IS_PROTO3_SINGULAR:
+            encoded_mod |= ENCODED_IS_PROTO3_SINGULAR
+        if field_mod & FIELD_IS_REQUIRED:
+            encoded_mod |= ENCODED_IS_REQUIRED
+
+        w.put(encoded_type)
+        w.put_modifier(encoded_mod)
+
+    def encode_enum(self, full_name: str) -> str:
+        """Mirror of upb_EnumDef_MiniDescriptorEncode()."""
+        enum = self.enums[full_name].desc
+        values = sorted({v.number & 0xFFFFFFFF for v in enum.value})
+
+        w = _Base92Writer()
+        w.put_raw(VERSION_ENUM)
+        mask = 0
+        last_written = 0
+        for value in values:
+            delta = value - last_written
+            if delta >= 5 and mask:
+                w.put(mask)
+                mask = 0
+                last_written += 5
+                delta -= 5
+            if delta >= 5:
+                w.put_varint(delta, MIN_SKIP, MAX_SKIP)
+                last_written += delta
+                delta = 0
+            mask |= 1 << delta
+        if mask:
+            w.put(mask)
+        return w.result()
+
+    # --- Linking ---
+
+    def sub_messages(self, full_name: str) -> List[str]:
+        """Sub-message types in the order upb_MiniTable_Link() expects them."""
+        msg = self.messages[full_name].desc
+        return [f.type_name for f in sorted(msg.field, key=lambda f: f.number)
+                if self.is_sub_message(f)]
+
+    def sub_enums(self, full_name: str) -> List[str]:
+        """Closed enum types in the order upb_MiniTable_Link() expects them."""
+        msg = self.messages[full_name].desc
+        return [f.type_name for f in sorted(msg.field, key=lambda f: f.number)
+                if self.is_closed_enum(f)]
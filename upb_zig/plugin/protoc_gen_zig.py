@@ -7,13 +7,28 @@ CodeGeneratorResponse to stdout, following the protoc plugin protocol.
 
 Usage:
     protoc --plugin=protoc-gen-zig=./protoc-gen-zig --zig_out=./gen foo.proto
+
+Options (passed as --zig_opt=key=value, comma separated):
+    minitable_mode=eager|lazy|def_pool
+        Default upb_zig.MiniTableMode for the generated files (eager).
 """
 
 import sys
 from google.protobuf.compiler import plugin_pb2 as plugin # pyright: ignore[reportMissingModuleSource]
 from google.protobuf.descriptor_pb2 import FileDescriptorProto # pyright: ignore[reportMissingModuleSource]
 
-from upb_zig.plugin.codegen import generate_file
+from upb_zig.plugin.codegen import generate_file, MINITABLE_MODES
+
+
+def parse_parameter(parameter: str) -> dict[str, str]:
+    """Parse the comma separated key=value plugin parameter."""
+    options: dict[str, str] = {}
+    for item in parameter.split(","):
+        if not item:
+            continue
+        key, _, value = item.partition("=")
+        options[key.strip()] = value.strip()
+    return options
 
 def main():
     if sys.stdin.isatty():
@@ -32,6 +47,17 @@ def main():
     # Create response
     response = plugin.CodeGeneratorResponse()
 
+    options = parse_parameter(request.parameter)
+    minitable_mode = options.pop("minitable_mode", "eager")
+    if minitable_mode not in MINITABLE_MODES:
+        response.error = f"Invalid minitable_mode '{minitable_mode}', expected one of: {', '.join(MINITABLE_MODES)}"
+        sys.stdout.buffer.write(response.SerializeToString())
+        return 1
+    if options:
+        response.error = f"Unknown plugin options: {', '.join(sorted(options))}"
+        sys.stdout.buffer.write(response.SerializeToString())
+        return 1
+
     # Indicate we support proto3 optional fields and editions
     response.supported_features = (
         plugin.CodeGeneratorResponse.FEATURE_PROTO3_OPTIONAL |
@@ -61,7 +87,7 @@ def main():
         out_file.name = file_name.replace(".proto", ".pb.zig")
 
         try:
-            out_file.content = generate_file(file_desc, file_map)
+            out_file.content = generate_file(file_desc, file_map, minitable_mode)
         except Exception as e:
             response.error = f"Error generating {file_name}: {e}"
             sys.stdout.buffer.write(response.SerializeToString())
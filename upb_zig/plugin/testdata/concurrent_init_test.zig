@@ -0,0 +1,58 @@
+//! Stress test for first use of generated messages from many threads.
+//! Lives in its own test binary so no message type is initialized before the
+//! threads are released.
+
+const std = @import("std");
+const upb = @import("upb_zig");
+const simple_pb = @import("simple_zig_pb");
+
+const thread_count = 16;
+
+const Shared = struct {
+    start: std.Thread.ResetEvent = .{},
+    failures: std.atomic.Value(u32) = .init(0),
+};
+
+fn roundTrip(shared: *Shared, id: i32) void {
+    shared.start.wait();
+    roundTripOrFail(id) catch {
+        _ = shared.failures.fetchAdd(1, .monotonic);
+    };
+}
+
+fn roundTripOrFail(id: i32) !void {
+    const arena = try upb.Arena.init(std.heap.page_allocator);
+    defer arena.deinit();
+
+    var person = try simple_pb.Person.init(arena);
+    person.setName("Concurrent");
+    person.setId(id);
+    var timestamp = try simple_pb.google_protobuf_timestamp.Timestamp.init(arena);
+    timestamp.setSeconds(id);
+    try person.setLastUpdated(timestamp);
+
+    const bytes = try person.encode();
+    const decoded = try simple_pb.Person.decode(arena, bytes);
+    if (decoded.getId() != id) return error.Mismatch;
+    if (!std.mem.eql(u8, decoded.getName(), "Concurrent")) return error.Mismatch;
+
+    const json = try person.encodeJson(.{});
+    const from_json = try simple_pb.Person.decodeJson(arena, json, .{});
+    if (from_json.getId() != id) return error.Mismatch;
+}
+
+test "first use of generated messages from many threads" {
+    var shared: Shared = .{};
+    var threads: [thread_count]std.Thread = undefined;
+    for (&threads, 0..) |*t, i| {
+        t.* = try std.Thread.spawn(.{}, roundTrip, .{ &shared, @as(i32, @intCast(i)) });
+    }
+
+    // Release every thread at once so they race on initialization.
+    shared.start.set();
+    for (threads) |t| t.join();
+
+    try std.testing.expectEqual(@as(u32, 0), shared.failures.load(.monotonic));
+    try std.testing.expect(simple_pb.Person.minitable != null);
+    try std.testing.expect(simple_pb.Person.msgdef != null);
+}
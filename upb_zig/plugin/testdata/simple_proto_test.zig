@@ -27,7 +27,7 @@ test "Person struct exists and has expected methods" {
     timestamp.setSeconds(12);
     timestamp.setNanos(333);
 
-    person.setLastUpdated(timestamp);
+    try person.setLastUpdated(timestamp);
 
 }
 
@@ -53,3 +53,142 @@ test "AddressBook struct exists" {
     _ = AddressBookType.encode;
     _ = @sizeOf(AddressBookType);
 }
+
+test "warmUpAll initializes every message in imported files" {
+    const stats = upb.warmUpAll(.{simple_pb}, .{ .json = true });
+
+    // simple.proto and the timestamp.proto it imports, whether this call or
+    // an earlier test warmed them up.
+    try std.testing.expect(stats.files <= 2);
+    try std.testing.expectEqual(@as(usize, 2), upb.filesWarmedUp());
+    try std.testing.expect(upb.miniTableArenaBytes() > 0);
+    try std.testing.expect(upb.sharedDefPoolBytes() > 0);
+    try std.testing.expect(simple_pb.Person.minitable != null);
+    try std.testing.expect(simple_pb.AddressBook.minitable != null);
+    try std.testing.expect(simple_pb.Person.PhoneNumber.minitable != null);
+    try std.testing.expect(simple_pb.google_protobuf_timestamp.Timestamp.minitable != null);
+    try std.testing.expect(simple_pb.Person.msgdef != null);
+
+    // Warming up again is a no-op
+    try std.testing.expectEqual(@as(usize, 0), upb.warmUpAll(.{simple_pb}, .{}).files);
+}
+
+test "message setters fuse arenas" {
+    const response_arena = try upb.Arena.init(std.testing.allocator);
+    defer response_arena.deinit();
+    const piece_arena = try upb.Arena.init(std.testing.allocator);
+
+    var book = try simple_pb.AddressBook.init(response_arena);
+    var person = try simple_pb.Person.init(piece_arena);
+    person.setId(7);
+    try book.addPeople(person);
+
+    // The person stays valid through the book after its own arena is gone.
+    piece_arena.deinit();
+    try std.testing.expectEqual(@as(i32, 7), book.getPeople(0).?.getId());
+}
+
+test "nested messages are full message types" {
+    const arena = try upb.Arena.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var phone = try simple_pb.Person.PhoneNumber.init(arena);
+    phone.setNumber("555-0100");
+    phone.setType(.PHONE_TYPE_MOBILE);
+    var person = try simple_pb.Person.init(arena);
+    try person.addPhones(phone);
+
+    const decoded = try simple_pb.Person.decode(arena, try person.encode());
+    const first = decoded.getPhones(0).?;
+    try std.testing.expectEqualStrings("555-0100", first.getNumber());
+    try std.testing.expectEqual(simple_pb.PhoneType.PHONE_TYPE_MOBILE, first.getType());
+}
+
+test "message setters reject arenas that cannot be fused" {
+    var buffer: [4096]u8 align(16) = undefined;
+    const response_arena = try upb.Arena.initWithBuffer(&buffer, std.testing.allocator);
+    defer response_arena.deinit();
+    const piece_arena = try upb.Arena.init(std.testing.allocator);
+    defer piece_arena.deinit();
+
+    var book = try simple_pb.AddressBook.init(response_arena);
+    var person = try simple_pb.Person.init(piece_arena);
+    person.setId(7);
+    try std.testing.expectError(error.ArenaFuseFailed, book.addPeople(person));
+
+    try book.addPeople(try person.clone(response_arena));
+    try std.testing.expectEqual(@as(i32, 7), book.getPeople(0).?.getId());
+}
+
+test "mergeFrom applies an update to an existing message" {
+    const arena = try upb.Arena.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var state = try simple_pb.Person.init(arena);
+    state.setName("John");
+    state.setId(1);
+
+    var update = try simple_pb.Person.init(arena);
+    update.setId(2);
+    update.setEmail("john@example.com");
+
+    try state.mergeFrom(try update.encode());
+    try std.testing.expectEqualStrings("John", state.getName());
+    try std.testing.expectEqual(@as(i32, 2), state.getId());
+    try std.testing.expectEqualStrings("john@example.com", state.getEmail());
+}
+
+test "repeated message fields can be edited in place" {
+    const arena = try upb.Arena.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var book = try simple_pb.AddressBook.init(arena);
+    for (0..3) |i| {
+        var person = try simple_pb.Person.init(arena);
+        person.setId(@intCast(i));
+        try book.addPeople(person);
+    }
+
+    var replacement = try simple_pb.Person.init(arena);
+    replacement.setId(9);
+    try book.setPeopleAt(0, replacement);
+    try book.swapRemovePeople(1);
+    try std.testing.expectEqual(@as(usize, 2), book.peopleCount());
+    try std.testing.expectEqual(@as(i32, 9), book.getPeople(0).?.getId());
+    try std.testing.expectEqual(@as(i32, 2), book.getPeople(1).?.getId());
+    try std.testing.expectError(error.IndexOutOfBounds, book.swapRemovePeople(2));
+
+    book.clearPeople();
+    try std.testing.expectEqual(@as(usize, 0), book.peopleCount());
+}
+
+test "sub-messages can be built in place" {
+    const arena = try upb.Arena.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var book = try simple_pb.AddressBook.init(arena);
+    for (0..3) |i| {
+        var person = try book.addNewPeople();
+        person.setId(@intCast(i));
+        var updated = try person.mutableLastUpdated();
+        updated.setSeconds(@intCast(i));
+    }
+
+    try std.testing.expectEqual(@as(usize, 3), book.peopleCount());
+    const last = book.getPeople(2).?;
+    try std.testing.expectEqual(@as(i32, 2), last.getId());
+    try std.testing.expectEqual(@as(i64, 2), last.getLastUpdated().?.getSeconds());
+}
+
+test "encodeIn writes into a scratch arena" {
+    const arena = try upb.Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    var scratch = try upb.Arena.init(std.testing.allocator);
+    defer scratch.deinit();
+
+    var person = try simple_pb.Person.init(arena);
+    person.setId(7);
+    const bytes = try person.encodeIn(scratch, .{});
+    try std.testing.expectEqualSlices(u8, try person.encode(), bytes);
+    try scratch.reset();
+}
@@ -3,6 +3,11 @@ const std = @import("std");
 pub fn build(b: *std.Build) void {
     const target = b.standardTargetOptions(.{});
     const optimize = b.standardOptimizeOption(.{});
+    // Zig compiles the upb C sources below with its bundled clang, so with LTO
+    // the linker can inline the upb_helpers.c wrappers into Zig callers. LTO is
+    // a property of the final executable: this option covers the tests and
+    // the bench step, and consumers set `.lto` on their own executable.
+    const lto = b.option(std.zig.LtoMode, "lto", "Link-time optimization across Zig and the upb C sources (none, full, thin)");
 
     const mod = b.addModule("upb_runtime", .{
         .root_source_file = b.path("upb_zig/runtime/re_export_everything.zig"),
@@ -208,8 +213,26 @@ pub fn build(b: *std.Build) void {
     const tests = b.addTest(.{
         .root_module = mod,
     });
+    tests.lto = lto;
 
     const run_tests = b.addRunArtifact(tests);
     const test_step = b.step("test", "Run upb_zig tests");
     test_step.dependOn(&run_tests.step);
+
+    // Compare `zig build bench -Doptimize=ReleaseFast` with and without -Dlto=full.
+    const bench_mod = b.createModule(.{
+        .root_source_file = b.path("upb_zig/runtime/lto_benchmark.zig"),
+        .target = target,
+        .optimize = optimize,
+    });
+    bench_mod.addImport("upb_runtime", mod);
+    const bench = b.addExecutable(.{
+        .name = "lto_benchmark",
+        .root_module = bench_mod,
+    });
+    bench.lto = lto;
+
+    const run_bench = b.addRunArtifact(bench);
+    const bench_step = b.step("bench", "Run the accessor and codec benchmark");
+    bench_step.dependOn(&run_bench.step);
 }
@@ -0,0 +1,53 @@
+//! Accessor and wire codec throughput for the runtime package, where Zig
+//! compiles upb with its bundled clang so LTO can reach across the C
+//! boundary. Compare:
+//!   zig build bench -Doptimize=ReleaseFast
+//!   zig build bench -Doptimize=ReleaseFast -Dlto=full
+//! With LTO the upb_helpers.c wrappers behind the accessors can be inlined.
+
+const std = @import("std");
+const runtime = @import("upb_runtime");
+const upb_zig = runtime.upb_zig;
+const timestamp_pb = runtime.wkt.timestamp_pb;
+
+const accessor_iterations: usize = 10_000_000;
+const codec_iterations: usize = 500_000;
+
+fn report(name: []const u8, elapsed_ns: u64, iterations: usize) void {
+    const per_op = @as(f64, @floatFromInt(elapsed_ns)) / @as(f64, @floatFromInt(iterations));
+    std.debug.print("{s:<20} {d:>8.2} ns/op\n", .{ name, per_op });
+}
+
+pub fn main() !void {
+    const arena = try upb_zig.Arena.init(std.heap.page_allocator);
+    defer arena.deinit();
+
+    var timestamp = try timestamp_pb.Timestamp.init(arena);
+
+    var timer = try std.time.Timer.start();
+
+    var sum: i64 = 0;
+    for (0..accessor_iterations) |i| {
+        timestamp.setSeconds(@intCast(i));
+        timestamp.setNanos(@intCast(i % 1_000_000_000));
+        sum +%= timestamp.getSeconds();
+        sum +%= timestamp.getNanos();
+    }
+    report("scalar get/set", timer.lap(), accessor_iterations);
+
+    // Decode and re-encode through one arena reset per iteration.
+    const encoded = try timestamp.encode();
+    var scratch = try upb_zig.Arena.init(std.heap.page_allocator);
+    defer scratch.deinit();
+    timer.reset();
+    var len: usize = 0;
+    for (0..codec_iterations) |_| {
+        const decoded = try timestamp_pb.Timestamp.decode(scratch, encoded);
+        len +%= (try decoded.encode()).len;
+        try scratch.reset();
+    }
+    report("decode + encode", timer.lap(), codec_iterations);
+
+    std.mem.doNotOptimizeAway(sum);
+    std.mem.doNotOptimizeAway(len);
+}
@@ -7,13 +7,22 @@
 
 #include "upb/message/accessors.h"
 #include "upb/message/array.h"
+#include "upb/message/copy.h"
+#include "upb/message/map.h"
 #include "upb/base/string_view.h"
 #include "upb/reflection/def.h"
 #include "upb/reflection/descriptor_bootstrap.h"
+#include "upb/reflection/internal/def_pool.h"
 #include "upb/mini_table/message.h"
+#include "upb/mini_descriptor/build_enum.h"
+#include "upb/mini_descriptor/decode.h"
+#include "upb/mini_descriptor/link.h"
 #include "upb/json/decode.h"
 #include "upb/json/encode.h"
 
+// Must be last.
+#include "upb/port/def.inc"
+
 // String/bytes getters and setters
 upb_StringView upb_zig_Message_GetString(
     const upb_Message* msg,
@@ -141,6 +150,12 @@ const upb_Array* upb_zig_Message_GetArray(
   return upb_Message_GetArray(msg, field);
 }
 
+upb_Array* upb_zig_Message_GetMutableArray(
+    upb_Message* msg,
+    const upb_MiniTableField* field) {
+  return upb_Message_GetMutableArray(msg, field);
+}
+
 upb_Array* upb_zig_Message_GetOrCreateMutableArray(
     upb_Message* msg,
     const upb_MiniTableField* field,
@@ -152,6 +167,22 @@ size_t upb_zig_Array_Size(const upb_Array* arr) {
   return upb_Array_Size(arr);
 }
 
+const void* upb_zig_Array_DataPtr(const upb_Array* arr) {
+  return upb_Array_DataPtr(arr);
+}
+
+void* upb_zig_Array_MutableDataPtr(upb_Array* arr) {
+  return upb_Array_MutableDataPtr(arr);
+}
+
+bool upb_zig_Array_Reserve(upb_Array* arr, size_t size, upb_Arena* arena) {
+  return upb_Array_Reserve(arr, size, arena);
+}
+
+bool upb_zig_Array_Resize(upb_Array* arr, size_t size, upb_Arena* arena) {
+  return upb_Array_Resize(arr, size, arena);
+}
+
 // Type-specific getters
 bool upb_zig_Array_GetBool(const upb_Array* arr, size_t index) {
   return upb_Array_Get(arr, index).bool_val;
@@ -244,6 +275,54 @@ bool upb_zig_Array_AppendMessage(upb_Array* arr, const upb_Message* val, upb_Are
   return upb_Array_Append(arr, msgval, arena);
 }
 
+// ============================================================================
+// Map operations
+// ============================================================================
+
+const upb_Map* upb_zig_Message_GetMap(
+    const upb_Message* msg,
+    const upb_MiniTableField* field) {
+  return upb_Message_GetMap(msg, field);
+}
+
+upb_Map* upb_zig_Message_GetMutableMap(
+    upb_Message* msg,
+    const upb_MiniTableField* field) {
+  return upb_Message_GetMutableMap(msg, field);
+}
+
+upb_Map* upb_zig_Message_GetOrCreateMutableMap(
+    upb_Message* msg,
+    const upb_MiniTable* map_entry_mini_table,
+    const upb_MiniTableField* field,
+    upb_Arena* arena) {
+  return upb_Message_GetOrCreateMutableMap(msg, map_entry_mini_table, field, arena);
+}
+
+size_t upb_zig_Map_Size(const upb_Map* map) {
+  return upb_Map_Size(map);
+}
+
+bool upb_zig_Map_Get(const upb_Map* map, const upb_MessageValue* key, upb_MessageValue* val) {
+  return upb_Map_Get(map, *key, val);
+}
+
+bool upb_zig_Map_Set(upb_Map* map, const upb_MessageValue* key, const upb_MessageValue* val, upb_Arena* arena) {
+  return upb_Map_Set(map, *key, *val, arena);
+}
+
+bool upb_zig_Map_Delete(upb_Map* map, const upb_MessageValue* key) {
+  return upb_Map_Delete(map, *key, NULL);
+}
+
+void upb_zig_Map_Clear(upb_Map* map) {
+  upb_Map_Clear(map);
+}
+
+bool upb_zig_Map_Next(const upb_Map* map, upb_MessageValue* key, upb_MessageValue* val, size_t* iter) {
+  return upb_Map_Next(map, key, val, iter);
+}
+
 // ============================================================================
 // Field presence check
 // ============================================================================
@@ -271,6 +350,38 @@ void upb_zig_Message_SetMessage(
   upb_Message_SetBaseFieldMessage(msg, field, sub_msg);
 }
 
+upb_Message* upb_zig_Message_GetOrCreateMutableMessage(
+    upb_Message* msg,
+    const upb_MiniTable* mini_table,
+    const upb_MiniTableField* field,
+    upb_Arena* arena) {
+  return upb_Message_GetOrCreateMutableMessage(msg, mini_table, field, arena);
+}
+
+upb_Message* upb_zig_Message_DeepClone(
+    const upb_Message* msg,
+    const upb_MiniTable* mini_table,
+    upb_Arena* arena) {
+  return upb_Message_DeepClone(msg, mini_table, arena);
+}
+
+upb_Message* upb_zig_Message_ShallowClone(
+    const upb_Message* msg,
+    const upb_MiniTable* mini_table,
+    upb_Arena* arena) {
+  return upb_Message_ShallowClone(msg, mini_table, arena);
+}
+
+void upb_zig_Message_ClearBaseField(
+    upb_Message* msg,
+    const upb_MiniTableField* field) {
+  upb_Message_ClearBaseField(msg, field);
+}
+
+void upb_zig_Message_DiscardUnknownShallow(upb_Message* msg) {
+  upb_Message_DiscardUnknown_shallow(msg);
+}
+
 // ============================================================================
 // Reflection API wrappers
 // ============================================================================
@@ -320,6 +431,34 @@ const upb_MessageDef* upb_zig_DefPool_FindMessageByName(
   return upb_DefPool_FindMessageByName(pool, name);
 }
 
+const upb_EnumDef* upb_zig_DefPool_FindEnumByName(
+    const upb_DefPool* pool,
+    const char* name) {
+  return upb_DefPool_FindEnumByName(pool, name);
+}
+
+size_t upb_zig_DefPool_SpaceAllocated(const upb_DefPool* pool) {
+  return upb_Arena_SpaceAllocated(_upb_DefPool_Arena(pool), NULL);
+}
+
+bool upb_zig_EnumDef_IsClosed(const upb_EnumDef* e) {
+  return upb_EnumDef_IsClosed(e);
+}
+
+bool upb_zig_MessageDef_MiniDescriptorEncode(
+    const upb_MessageDef* m,
+    upb_Arena* arena,
+    upb_StringView* out) {
+  return upb_MessageDef_MiniDescriptorEncode(m, arena, out);
+}
+
+bool upb_zig_EnumDef_MiniDescriptorEncode(
+    const upb_EnumDef* e,
+    upb_Arena* arena,
+    upb_StringView* out) {
+  return upb_EnumDef_MiniDescriptorEncode(e, arena, out);
+}
+
 const upb_MiniTable* upb_zig_MessageDef_MiniTable(const upb_MessageDef* m) {
   return upb_MessageDef_MiniTable(m);
 }
@@ -330,6 +469,71 @@ const upb_MiniTableField* upb_zig_MiniTable_FindFieldByNumber(
   return upb_MiniTable_FindFieldByNumber(mt, field_number);
 }
 
+int upb_zig_MiniTable_FieldCount(const upb_MiniTable* mt) {
+  return upb_MiniTable_FieldCount(mt);
+}
+
+const upb_MiniTableField* upb_zig_MiniTable_GetFieldByIndex(
+    const upb_MiniTable* mt,
+    uint32_t index) {
+  return upb_MiniTable_GetFieldByIndex(mt, index);
+}
+
+const upb_MiniTable* upb_zig_MiniTable_GetSubMessageTable(
+    const upb_MiniTable* mt,
+    const upb_MiniTableField* field) {
+  return upb_MiniTable_GetSubMessageTable(mt, field);
+}
+
+uint32_t upb_zig_MiniTableField_Number(const upb_MiniTableField* field) {
+  return upb_MiniTableField_Number(field);
+}
+
+int upb_zig_MiniTableField_Type(const upb_MiniTableField* field) {
+  return (int)upb_MiniTableField_Type(field);
+}
+
+bool upb_zig_MiniTableField_IsArray(const upb_MiniTableField* field) {
+  return upb_MiniTableField_IsArray(field);
+}
+
+bool upb_zig_MiniTableField_IsMap(const upb_MiniTableField* field) {
+  return upb_MiniTableField_IsMap(field);
+}
+
+// ============================================================================
+// MiniDescriptor wrappers
+// ============================================================================
+
+upb_MiniTable* upb_zig_MiniTable_Build(
+    const char* data,
+    size_t len,
+    upb_Arena* arena,
+    upb_Status* status) {
+  return upb_MiniTable_Build(data, len, arena, status);
+}
+
+const upb_MiniTableEnum* upb_zig_MiniTableEnum_Build(
+    const char* data,
+    size_t len,
+    upb_Arena* arena,
+    upb_Status* status) {
+  return upb_MiniTableEnum_Build(data, len, arena, status);
+}
+
+size_t upb_zig_Arena_Remaining(const upb_Arena* arena) {
+  return UPB_PRIVATE(_upb_ArenaHas)(arena);
+}
+
+bool upb_zig_MiniTable_Link(
+    upb_MiniTable* mt,
+    const upb_MiniTable** sub_tables,
+    size_t sub_table_count,
+    const upb_MiniTableEnum** sub_enums,
+    size_t sub_enum_count) {
+  return upb_MiniTable_Link(mt, sub_tables, sub_table_count, sub_enums, sub_enum_count);
+}
+
 // ============================================================================
 // JSON API wrappers
 // ============================================================================
@@ -356,3 +560,5 @@ size_t upb_zig_JsonEncode(
     upb_Status* status) {
   return upb_JsonEncode(msg, m, ext_pool, options, buf, size, status);
 }
+
+#include "upb/port/undef.inc"
@@ -12,6 +12,7 @@
 #include "upb/base/string_view.h"
 #include "upb/base/status.h"
 #include "upb/mem/arena.h"
+#include "upb/message/value.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -20,7 +21,10 @@
 typedef struct upb_DefPool upb_DefPool;
 typedef struct upb_FileDef upb_FileDef;
 typedef struct upb_MessageDef upb_MessageDef;
+typedef struct upb_EnumDef upb_EnumDef;
 typedef struct upb_Array upb_Array;
+typedef struct upb_Map upb_Map;
+typedef struct upb_MiniTableEnum upb_MiniTableEnum;
 
 // JSON decode result codes
 enum {
@@ -125,6 +129,11 @@ const upb_Array* upb_zig_Message_GetArray(
     const upb_Message* msg,
     const upb_MiniTableField* field);
 
+// Get mutable array from message (may return NULL)
+upb_Array* upb_zig_Message_GetMutableArray(
+    upb_Message* msg,
+    const upb_MiniTableField* field);
+
 // Get or create mutable array (for appending elements)
 upb_Array* upb_zig_Message_GetOrCreateMutableArray(
     upb_Message* msg,
@@ -134,6 +143,16 @@ upb_Array* upb_zig_Message_GetOrCreateMutableArray(
 // Get array size
 size_t upb_zig_Array_Size(const upb_Array* arr);
 
+// Contiguous element storage of an array
+const void* upb_zig_Array_DataPtr(const upb_Array* arr);
+void* upb_zig_Array_MutableDataPtr(upb_Array* arr);
+
+// Grow capacity to at least `size` elements (length unchanged)
+bool upb_zig_Array_Reserve(upb_Array* arr, size_t size, upb_Arena* arena);
+
+// Set the length to `size`; new elements are zeroed
+bool upb_zig_Array_Resize(upb_Array* arr, size_t size, upb_Arena* arena);
+
 // Type-specific array element getters
 bool upb_zig_Array_GetBool(const upb_Array* arr, size_t index);
 int32_t upb_zig_Array_GetInt32(const upb_Array* arr, size_t index);
@@ -156,6 +175,45 @@ bool upb_zig_Array_AppendDouble(upb_Array* arr, double val, upb_Arena* arena);
 bool upb_zig_Array_AppendString(upb_Array* arr, upb_StringView val, upb_Arena* arena);
 bool upb_zig_Array_AppendMessage(upb_Array* arr, const upb_Message* val, upb_Arena* arena);
 
+// ============================================================================
+// Map operations
+// ============================================================================
+// Keys and values are passed by pointer so Zig never passes the
+// upb_MessageValue union by value across the C ABI.
+
+// Get map from message (read-only, may return NULL)
+const upb_Map* upb_zig_Message_GetMap(
+    const upb_Message* msg,
+    const upb_MiniTableField* field);
+
+// Get mutable map from message (may return NULL)
+upb_Map* upb_zig_Message_GetMutableMap(
+    upb_Message* msg,
+    const upb_MiniTableField* field);
+
+// Get or create mutable map (for inserting entries)
+upb_Map* upb_zig_Message_GetOrCreateMutableMap(
+    upb_Message* msg,
+    const upb_MiniTable* map_entry_mini_table,
+    const upb_MiniTableField* field,
+    upb_Arena* arena);
+
+size_t upb_zig_Map_Size(const upb_Map* map);
+
+// Look up `key`; returns false if absent
+bool upb_zig_Map_Get(const upb_Map* map, const upb_MessageValue* key, upb_MessageValue* val);
+
+// Insert or replace (returns false on allocation failure)
+bool upb_zig_Map_Set(upb_Map* map, const upb_MessageValue* key, const upb_MessageValue* val, upb_Arena* arena);
+
+// Remove `key`; returns false if absent
+bool upb_zig_Map_Delete(upb_Map* map, const upb_MessageValue* key);
+
+void upb_zig_Map_Clear(upb_Map* map);
+
+// Advance `iter` (start at kUpb_Map_Begin); returns false at the end
+bool upb_zig_Map_Next(const upb_Map* map, upb_MessageValue* key, upb_MessageValue* val, size_t* iter);
+
 // ============================================================================
 // Field presence check
 // ============================================================================
@@ -180,6 +238,34 @@ void upb_zig_Message_SetMessage(
     const upb_MiniTableField* field,
     upb_Message* sub_msg);
 
+// Get the sub-message on a message field, creating an empty one in `arena`
+// if it is not set (returns NULL on allocation failure)
+upb_Message* upb_zig_Message_GetOrCreateMutableMessage(
+    upb_Message* msg,
+    const upb_MiniTable* mini_table,
+    const upb_MiniTableField* field,
+    upb_Arena* arena);
+
+// Deep-copy a message and everything it references into `arena`
+upb_Message* upb_zig_Message_DeepClone(
+    const upb_Message* msg,
+    const upb_MiniTable* mini_table,
+    upb_Arena* arena);
+
+// Copy a message's fields into `arena`, sharing its sub-messages and arrays
+upb_Message* upb_zig_Message_ShallowClone(
+    const upb_Message* msg,
+    const upb_MiniTable* mini_table,
+    upb_Arena* arena);
+
+// Clear a field (for arrays, only drops this message's reference)
+void upb_zig_Message_ClearBaseField(
+    upb_Message* msg,
+    const upb_MiniTableField* field);
+
+// Drop this message's unknown fields (not those of its sub-messages)
+void upb_zig_Message_DiscardUnknownShallow(upb_Message* msg);
+
 // ============================================================================
 // Reflection API wrappers - for loading MiniTables from serialized descriptors
 // ============================================================================
@@ -204,6 +290,28 @@ const upb_MessageDef* upb_zig_DefPool_FindMessageByName(
     const upb_DefPool* pool,
     const char* name);
 
+// Find an enum definition by fully-qualified name
+const upb_EnumDef* upb_zig_DefPool_FindEnumByName(
+    const upb_DefPool* pool,
+    const char* name);
+
+// Bytes of block space held by the pool's arena (its defs and MiniTables)
+size_t upb_zig_DefPool_SpaceAllocated(const upb_DefPool* pool);
+
+// Whether an enum is closed (unknown values go to unknown fields)
+bool upb_zig_EnumDef_IsClosed(const upb_EnumDef* e);
+
+// upb's own MiniDescriptor for a message or enum definition, allocated from
+// `arena`. Returns false on allocation failure.
+bool upb_zig_MessageDef_MiniDescriptorEncode(
+    const upb_MessageDef* m,
+    upb_Arena* arena,
+    upb_StringView* out);
+bool upb_zig_EnumDef_MiniDescriptorEncode(
+    const upb_EnumDef* e,
+    upb_Arena* arena,
+    upb_StringView* out);
+
 // Get the MiniTable for a message definition
 const upb_MiniTable* upb_zig_MessageDef_MiniTable(const upb_MessageDef* m);
 
@@ -212,6 +320,55 @@ const upb_MiniTableField* upb_zig_MiniTable_FindFieldByNumber(
     const upb_MiniTable* mt,
     uint32_t field_number);
 
+// Iterate a MiniTable's fields
+int upb_zig_MiniTable_FieldCount(const upb_MiniTable* mt);
+const upb_MiniTableField* upb_zig_MiniTable_GetFieldByIndex(
+    const upb_MiniTable* mt,
+    uint32_t index);
+
+// MiniTable of a message field's type (NULL if unlinked)
+const upb_MiniTable* upb_zig_MiniTable_GetSubMessageTable(
+    const upb_MiniTable* mt,
+    const upb_MiniTableField* field);
+
+// Field properties
+uint32_t upb_zig_MiniTableField_Number(const upb_MiniTableField* field);
+int upb_zig_MiniTableField_Type(const upb_MiniTableField* field);
+bool upb_zig_MiniTableField_IsArray(const upb_MiniTableField* field);
+bool upb_zig_MiniTableField_IsMap(const upb_MiniTableField* field);
+
+// ============================================================================
+// MiniDescriptor wrappers - for building MiniTables without a DefPool
+// ============================================================================
+
+// Build a MiniTable from a message MiniDescriptor. The table is allocated
+// from `arena` and must be linked before use if it has sub-messages or
+// closed enums. Returns NULL on failure.
+upb_MiniTable* upb_zig_MiniTable_Build(
+    const char* data,
+    size_t len,
+    upb_Arena* arena,
+    upb_Status* status);
+
+// Build a MiniTableEnum from an enum MiniDescriptor. Returns NULL on failure.
+const upb_MiniTableEnum* upb_zig_MiniTableEnum_Build(
+    const char* data,
+    size_t len,
+    upb_Arena* arena,
+    upb_Status* status);
+
+// Bytes left in the arena's current block
+size_t upb_zig_Arena_Remaining(const upb_Arena* arena);
+
+// Link sub-message tables and closed enum tables into a MiniTable.
+// Both arrays are in field number order. Returns false on mismatch.
+bool upb_zig_MiniTable_Link(
+    upb_MiniTable* mt,
+    const upb_MiniTable** sub_tables,
+    size_t sub_table_count,
+    const upb_MiniTableEnum** sub_enums,
+    size_t sub_enum_count);
+
 // ============================================================================
 // JSON API wrappers
 // ============================================================================
@@ -33,6 +33,7 @@ pub const upb_Arena = c.upb_Arena;
 pub const upb_Message = c.upb_Message;
 pub const upb_MiniTable = c.upb_MiniTable;
 pub const upb_MiniTableField = c.upb_MiniTableField;
+pub const upb_MiniTableEnum = c.upb_MiniTableEnum;
 pub const upb_StringView = c.upb_StringView;
 pub const upb_Status = c.upb_Status;
 
@@ -41,26 +42,311 @@ pub const upb_DefPool = c.upb_DefPool;
 pub const upb_FileDef = c.upb_FileDef;
 pub const upb_MessageDef = c.upb_MessageDef;
 
+/// Build-time options, declared by the root source file:
+///
+///     pub const upb_zig_options: upb_zig.Options = .{ .assume_warm = true };
+pub const Options = struct {
+    /// Generated accessors skip their ensureInit() check. Only set this if
+    /// main() calls warmUpAll() for every generated module before any
+    /// message is used; Debug and ReleaseSafe builds assert that it did.
+    assume_warm: bool = false,
+    /// Scalar and string accessors read and write message memory directly in
+    /// Zig so they can be inlined, instead of calling the upb C accessors in
+    /// upb_helpers.c. This relies on a mirror of upb's private field layout
+    /// (checked at compile time) and is opt-in until the conformance suite
+    /// passes with it (//upb_zig/conformance:upb_native_fails).
+    native_accessors: bool = false,
+    /// Static first block of the arena that MiniTables are built into.
+    /// Tables that don't fit spill to the C heap; raise this until
+    /// miniTableArenaHeapBytes() is 0 after warm-up to keep startup off the
+    /// heap.
+    minitable_arena_bytes: usize = 16 * 1024,
+};
+
+pub const root_options: Options = if (@hasDecl(@import("root"), "upb_zig_options"))
+    @import("root").upb_zig_options
+else
+    .{};
+
+/// Block sizing for an Arena's requests to its Zig allocator.
+pub const ArenaOptions = struct {
+    /// Smallest block requested from the Zig allocator. Smaller upb requests
+    /// are rounded up and upb is told the real size, so it uses the whole
+    /// block instead of coming back for another one.
+    min_block_size: usize = 0,
+    /// Upper bound on that rounding. upb requests larger than this are still
+    /// allocated at their exact size, since upb needs the whole block.
+    max_block_size: usize = std.math.maxInt(usize),
+    /// Largest block Arena.reset() keeps for reuse. Larger blocks are
+    /// returned to the allocator so one huge request doesn't pin its memory.
+    max_retained_block: usize = 1024 * 1024,
+    /// Hard limit on the bytes the arena may hold, counting a caller's
+    /// first block. Allocations past it fail, and decode()/jsonDecode()
+    /// report error.ArenaBudgetExceeded, so one oversized payload cannot
+    /// balloon the process.
+    max_bytes: usize = std.math.maxInt(usize),
+};
+
+/// Memory usage of an Arena, from Arena.stats().
+pub const ArenaStats = struct {
+    /// Bytes upb asked the allocator for in the arena's live blocks,
+    /// before min_block_size rounding. A caller's buffer is not counted,
+    /// since upb never asked for it; a retained block counts what upb asked
+    /// for when it was handed out.
+    requested: usize,
+    /// Bytes the arena holds right now, including min_block_size rounding
+    /// and a caller-supplied or retained first block.
+    reserved: usize,
+    /// Live blocks, counting the first block.
+    blocks: usize,
+    /// Highest `reserved` since the arena was created, across resets.
+    peak_reserved: usize,
+    /// upb's count of block space, summed over every arena this one is
+    /// fused with (see upb_Arena_SpaceAllocated).
+    space_allocated: usize,
+    /// Arenas in this one's fuse group, itself included.
+    fused_count: usize,
+    /// Allocations refused by ArenaOptions.max_bytes since the arena was created.
+    refused: usize,
+};
+
 /// Wrapper that bridges Zig's std.mem.Allocator to upb's upb_alloc interface.
 /// The upb_alloc field must be first so we can use @fieldParentPtr in the callback.
 ///
-/// Note: upb's free() doesn't pass the allocation size, but Zig's allocator needs it.
-/// We solve this by prepending each allocation with a size header.
+/// Note: upb's free() doesn't reliably pass the allocation size, but Zig's
+/// allocator needs it. upb arenas only allocate a handful of geometrically
+/// growing blocks, so sizes live in a side table rather than in a header
+/// in front of every block.
 const ZigUpbAlloc = struct {
     upb_alloc: c.upb_alloc,
     zig_allocator: std.mem.Allocator,
+    options: ArenaOptions,
+    /// Every live block, keyed by address.
+    blocks: BlockTable = .{},
+    /// Bytes in `blocks`, and the most the arena has held at once
+    /// (including `initial`), for Arena.stats().
+    block_bytes: usize = 0,
+    peak_bytes: usize = 0,
+    /// Allocations refused by options.max_bytes.
+    refused: usize = 0,
+    /// The caller's buffer, handed to upb_Arena_Init as its first block
+    /// (not tracked in `blocks`). See Arena.initWithBuffer.
+    initial: ?[]u8 = null,
+    /// Set while Arena.reset() frees the upb arena; the largest freed block
+    /// is held in `retained` instead of being returned, and allocFn hands
+    /// it to the new arena's first block request.
+    retaining: bool = false,
+    retained: ?[]u8 = null,
+    /// Arena.reset() freed the upb arena but could not create a new one;
+    /// Arena.deinit only destroys the bridge.
+    detached: bool = false,
+    /// This bridge lives in a caller-supplied buffer (see Arena.initWithBuffer).
+    in_buffer: bool = false,
+    /// upb destroys this bridge through cleanupFn once the arena's last block
+    /// is freed. Not possible for arenas with a caller's buffer, which
+    /// Arena.deinit destroys itself.
+    upb_owned: bool = false,
+    /// Fused with another arena (see Arena.fuse): upb may free our blocks
+    /// after Arena.deinit returns, from whichever thread frees the group last.
+    fused: bool = false,
+    /// Intrusive links for an ArenaPool's per-thread idle list.
+    idle_next: ?*Self = null,
+    idle_arena: ?*c.upb_Arena = null,
 
     const Self = @This();
-    const Header = struct { size: usize };
-    const header_size = @sizeOf(Header);
+    const Block = struct {
+        len: usize,
+        /// What upb asked for; less than `len` after min_block_size rounding.
+        requested: usize,
+    };
 
-    pub fn init(allocator: std.mem.Allocator) Self {
+    /// Block sizes by address. upb's block sizes grow geometrically, so
+    /// almost every arena fits in the inline slots and never allocates; a
+    /// hash map takes over only for arenas with more blocks than that.
+    const BlockTable = struct {
+        inline_addrs: [inline_capacity]usize = undefined,
+        inline_blocks: [inline_capacity]Block = undefined,
+        inline_len: usize = 0,
+        overflow: std.AutoHashMapUnmanaged(usize, Block) = .empty,
+
+        const inline_capacity = 8;
+
+        fn deinit(self: *BlockTable, gpa: std.mem.Allocator) void {
+            self.overflow.deinit(gpa);
+        }
+
+        fn count(self: *const BlockTable) usize {
+            return self.inline_len + self.overflow.count();
+        }
+
+        fn put(self: *BlockTable, gpa: std.mem.Allocator, addr: usize, block: Block) !void {
+            if (self.inline_len < inline_capacity) {
+                self.inline_addrs[self.inline_len] = addr;
+                self.inline_blocks[self.inline_len] = block;
+                self.inline_len += 1;
+                return;
+            }
+            try self.overflow.put(gpa, addr, block);
+        }
+
+        fn get(self: *const BlockTable, addr: usize) ?Block {
+            if (std.mem.indexOfScalar(usize, self.inline_addrs[0..self.inline_len], addr)) |i| {
+                return self.inline_blocks[i];
+            }
+            return self.overflow.get(addr);
+        }
+
+        fn remove(self: *BlockTable, addr: usize) ?Block {
+            if (std.mem.indexOfScalar(usize, self.inline_addrs[0..self.inline_len], addr)) |i| {
+                const block = self.inline_blocks[i];
+                self.inline_len -= 1;
+                self.inline_addrs[i] = self.inline_addrs[self.inline_len];
+                self.inline_blocks[i] = self.inline_blocks[self.inline_len];
+                return block;
+            }
+            const entry = self.overflow.fetchRemove(addr) orelse return null;
+            return entry.value;
+        }
+
+        /// Move the entry for `old_addr` (which must exist) to `addr`.
+        /// Never allocates: the entry keeps its slot or its map capacity.
+        fn replace(self: *BlockTable, old_addr: usize, addr: usize, block: Block) void {
+            if (std.mem.indexOfScalar(usize, self.inline_addrs[0..self.inline_len], old_addr)) |i| {
+                self.inline_addrs[i] = addr;
+                self.inline_blocks[i] = block;
+                return;
+            }
+            _ = self.overflow.remove(old_addr);
+            self.overflow.putAssumeCapacity(addr, block);
+        }
+
+        fn iterator(self: *const BlockTable) Iterator {
+            return .{ .table = self, .overflow = self.overflow.valueIterator() };
+        }
+
+        const Iterator = struct {
+            table: *const BlockTable,
+            index: usize = 0,
+            overflow: std.AutoHashMapUnmanaged(usize, Block).ValueIterator,
+
+            fn next(it: *Iterator) ?*const Block {
+                if (it.index < it.table.inline_len) {
+                    defer it.index += 1;
+                    return &it.table.inline_blocks[it.index];
+                }
+                return it.overflow.next();
+            }
+        };
+    };
+
+    /// UPB_MALLOC_ALIGN. upb aligns every allocation inside a block itself
+    /// and only assumes blocks are 8-byte aligned (it aligns a caller's
+    /// initial buffer to the same). The old header-based bridge handed upb
+    /// pointers 8 bytes past a 16-aligned allocation, so 8 is also all upb
+    /// ever got; asking for 16 would only add padding in allocators that
+    /// honor it.
+    const block_alignment: std.mem.Alignment = .@"8";
+
+    pub fn init(allocator: std.mem.Allocator, options: ArenaOptions) Self {
         return .{
             .upb_alloc = .{ .func = allocFn },
             .zig_allocator = allocator,
+            .options = options,
         };
     }
 
+    /// Free the side table and any retained block. Every block upb
+    /// allocated must already have been returned.
+    pub fn deinit(self: *Self) void {
+        self.freeRetained();
+        self.blocks.deinit(self.zig_allocator);
+    }
+
+    fn destroy(self: *Self) void {
+        self.deinit();
+        if (!self.in_buffer) self.zig_allocator.destroy(self);
+    }
+
+    /// Register cleanupFn on a freshly initialized upb arena using this bridge.
+    fn attach(self: *Self, arena: *c.upb_Arena) void {
+        self.upb_owned = c.upb_Arena_SetAllocCleanup(arena, cleanupFn);
+    }
+
+    /// Called by upb after the arena's last block is freed, which for a fused
+    /// arena may be long after Arena.deinit. Arena.reset() keeps the bridge.
+    fn cleanupFn(alloc: [*c]c.upb_alloc) callconv(.c) void {
+        const self: *Self = @alignCast(@fieldParentPtr("upb_alloc", @as(*c.upb_alloc, alloc)));
+        if (self.retaining) return;
+        self.destroy();
+    }
+
+    /// Hold on to the largest block freed during Arena.reset(), up to
+    /// options.max_retained_block; free the rest.
+    fn retainOrFree(self: *Self, mem: [*]u8, len: usize) void {
+        const best = if (self.retained) |r| r.len else 0;
+        if (len <= best or len > self.options.max_retained_block) {
+            self.freeBlock(mem, len);
+            return;
+        }
+        if (self.retained) |r| self.freeBlock(r.ptr, r.len);
+        self.retained = mem[0..len];
+    }
+
+    fn freeRetained(self: *Self) void {
+        const block = self.retained orelse return;
+        self.retained = null;
+        self.freeBlock(block.ptr, block.len);
+    }
+
+    /// Serve a block request from the block kept by Arena.reset(), if it is
+    /// large enough. It is already counted against options.max_bytes.
+    fn takeRetained(self: *Self, size: usize) ?[*]u8 {
+        const block = self.retained orelse return null;
+        if (block.len < size) {
+            // upb's first request is small; a block too small for it is
+            // not worth keeping for a later one.
+            self.freeRetained();
+            return null;
+        }
+        self.blocks.put(self.zig_allocator, @intFromPtr(block.ptr), .{ .len = block.len, .requested = size }) catch return null;
+        self.retained = null;
+        self.block_bytes += block.len;
+        return block.ptr;
+    }
+
+    /// Bytes held from the allocator or the caller's buffer.
+    fn reservedBytes(self: *const Self) usize {
+        const initial = if (self.initial) |block| block.len else 0;
+        const retained = if (self.retained) |block| block.len else 0;
+        return self.block_bytes + initial + retained;
+    }
+
+    /// Account for a block that grew from `old_len` (0 when new) to `len`.
+    fn noteResize(self: *Self, old_len: usize, len: usize) void {
+        self.block_bytes = self.block_bytes + len - old_len;
+        self.peak_bytes = @max(self.peak_bytes, self.reservedBytes());
+    }
+
+    /// Size of a block for `size` bytes replacing one of `old_len` (0 when
+    /// new): rounded as blockSize() does, but only up to options.max_bytes.
+    /// Null if `size` itself would exceed the budget.
+    fn budgetedSize(self: *Self, size: usize, old_len: usize) ?usize {
+        const available = self.options.max_bytes -| (self.reservedBytes() - old_len);
+        if (size > available) {
+            self.refused += 1;
+            return null;
+        }
+        return @min(self.blockSize(size), available);
+    }
+
+    fn blockSize(self: *const Self, size: usize) usize {
+        return @max(size, @min(self.options.min_block_size, self.options.max_block_size));
+    }
+
+    fn freeBlock(self: *Self, mem: [*]u8, len: usize) void {
+        self.zig_allocator.rawFree(mem[0..len], block_alignment, @returnAddress());
+    }
+
     /// The C callback function that upb calls for all allocations.
     /// Implements combined malloc/realloc/free semantics:
     /// - ptr == null, size > 0  → malloc
@@ -73,38 +359,53 @@ const ZigUpbAlloc = struct {
         if (size == 0) {
             // Free
             if (ptr) |p| {
-                const user_ptr: [*]u8 = @ptrCast(p);
-                const header_ptr: [*]u8 = user_ptr - header_size;
-                const header: *Header = @ptrCast(@alignCast(header_ptr));
-                const total_size = header.size + header_size;
-                const slice: [*]align(16) u8 = @ptrCast(@alignCast(header_ptr));
-                self.zig_allocator.free(slice[0..total_size]);
+                const block = self.blocks.remove(@intFromPtr(p)) orelse return null;
+                self.block_bytes -= block.len;
+                if (self.retaining) {
+                    self.retainOrFree(@ptrCast(p), block.len);
+                } else {
+                    self.freeBlock(@ptrCast(p), block.len);
+                }
             }
             return null;
         }
 
         if (ptr == null) {
-            // Malloc: allocate header + requested size
-            const total_size = header_size + size;
-            const mem = self.zig_allocator.alignedAlloc(u8, .@"16", total_size) catch return null;
-            const header: *Header = @ptrCast(mem.ptr);
-            header.size = size;
-            if (actual_size != null) actual_size.* = size;
-            return mem.ptr + header_size;
+            // Malloc
+            if (self.takeRetained(size)) |mem| {
+                const len = self.blocks.get(@intFromPtr(mem)).?.len;
+                if (actual_size != null) actual_size.* = len;
+                return mem;
+            }
+            const len = self.budgetedSize(size, 0) orelse return null;
+            const mem = self.zig_allocator.rawAlloc(len, block_alignment, @returnAddress()) orelse return null;
+            self.blocks.put(self.zig_allocator, @intFromPtr(mem), .{ .len = len, .requested = size }) catch {
+                self.freeBlock(mem, len);
+                return null;
+            };
+            self.noteResize(0, len);
+            if (actual_size != null) actual_size.* = len;
+            return mem;
         }
 
         // Realloc
-        const user_ptr: [*]u8 = @ptrCast(ptr.?);
-        const header_ptr: [*]align(16) u8 = @ptrCast(@alignCast(user_ptr - header_size));
-        const header: *Header = @ptrCast(header_ptr);
-        const old_total_size = header.size + header_size;
-        const new_total_size = size + header_size;
-
-        const new_mem = self.zig_allocator.realloc(header_ptr[0..old_total_size], new_total_size) catch return null;
-        const new_header: *Header = @ptrCast(new_mem.ptr);
-        new_header.size = size;
-        if (actual_size != null) actual_size.* = size;
-        return new_mem.ptr + header_size;
+        const old_mem: [*]u8 = @ptrCast(ptr.?);
+        const old_len = (self.blocks.get(@intFromPtr(old_mem)) orelse return null).len;
+        const len = self.budgetedSize(size, old_len) orelse return null;
+        const block: Block = .{ .len = len, .requested = size };
+        if (self.zig_allocator.rawRemap(old_mem[0..old_len], block_alignment, len, @returnAddress())) |mem| {
+            self.blocks.replace(@intFromPtr(old_mem), @intFromPtr(mem), block);
+            self.noteResize(old_len, len);
+            if (actual_size != null) actual_size.* = len;
+            return mem;
+        }
+        const mem = self.zig_allocator.rawAlloc(len, block_alignment, @returnAddress()) orelse return null;
+        @memcpy(mem[0..@min(old_len, len)], old_mem[0..@min(old_len, len)]);
+        self.blocks.replace(@intFromPtr(old_mem), @intFromPtr(mem), block);
+        self.freeBlock(old_mem, old_len);
+        self.noteResize(old_len, len);
+        if (actual_size != null) actual_size.* = len;
+        return mem;
     }
 };
 
@@ -121,16 +422,22 @@ pub const Arena = struct {
     /// Create a new arena using the provided Zig allocator.
     /// All upb allocations will flow through this allocator.
     pub fn init(allocator: std.mem.Allocator) !Arena {
+        return initWithOptions(allocator, .{});
+    }
+
+    /// Create a new arena with explicit block sizing.
+    pub fn initWithOptions(allocator: std.mem.Allocator, options: ArenaOptions) !Arena {
         // Allocate the ZigUpbAlloc wrapper
         const zig_alloc = allocator.create(ZigUpbAlloc) catch return error.OutOfMemory;
-        zig_alloc.* = ZigUpbAlloc.init(allocator);
+        zig_alloc.* = ZigUpbAlloc.init(allocator, options);
 
         // Create upb arena with our custom allocator (no initial block)
         const arena = c.upb_Arena_Init(null, 0, &zig_alloc.upb_alloc);
         if (arena == null) {
-            allocator.destroy(zig_alloc);
+            zig_alloc.destroy();
             return error.OutOfMemory;
         }
+        zig_alloc.attach(arena.?);
 
         return Arena{
             .ptr = arena.?,
@@ -139,10 +446,127 @@ pub const Arena = struct {
         };
     }
 
-    /// Free the arena and all allocations made from it.
+    /// Create an arena whose first block is `buf`, e.g. a stack or
+    /// threadlocal buffer. `fallback` is only used once `buf` is full, so
+    /// small messages are handled with no heap traffic at all. `buf` must
+    /// outlive the arena.
+    pub fn initWithBuffer(buf: []u8, fallback: std.mem.Allocator) !Arena {
+        return initWithBufferOptions(buf, fallback, .{});
+    }
+
+    /// initWithBuffer() with explicit options. `buf` counts towards
+    /// max_bytes, and min_block_size/max_block_size apply to the blocks
+    /// taken from `fallback` once it is full.
+    pub fn initWithBufferOptions(buf: []u8, fallback: std.mem.Allocator, options: ArenaOptions) !Arena {
+        // The allocator bridge goes at the front of the buffer, upb's arena
+        // header and first block after it.
+        const start = std.mem.alignForward(usize, @intFromPtr(buf.ptr), @alignOf(ZigUpbAlloc));
+        const header_end = start + @sizeOf(ZigUpbAlloc);
+        if (header_end > @intFromPtr(buf.ptr) + buf.len) {
+            return initWithOptions(fallback, options);
+        }
+        const zig_alloc: *ZigUpbAlloc = @ptrFromInt(start);
+        zig_alloc.* = ZigUpbAlloc.init(fallback, options);
+        zig_alloc.in_buffer = true;
+
+        const rest = buf[header_end - @intFromPtr(buf.ptr) ..];
+        zig_alloc.initial = rest;
+        const arena = c.upb_Arena_Init(rest.ptr, rest.len, &zig_alloc.upb_alloc);
+        if (arena == null) {
+            zig_alloc.deinit();
+            return error.OutOfMemory;
+        }
+        zig_alloc.attach(arena.?);
+
+        return Arena{
+            .ptr = arena.?,
+            .zig_alloc = zig_alloc,
+            .allocator = fallback,
+        };
+    }
+
+    /// Free everything allocated from the arena but keep its largest block
+    /// (up to ArenaOptions.max_retained_block) for the fresh arena's first
+    /// block, so a request loop that resets one arena performs no allocator
+    /// calls once it reaches steady state. A caller-supplied buffer is
+    /// always reused. The fresh arena can be fused like a new one.
+    /// Invalidates every message allocated from the arena, and any copies
+    /// of this Arena value.
+    ///
+    /// A fused arena's blocks outlive it, so it is replaced by a new arena
+    /// with the same options instead; if that fails the arena is unchanged.
+    /// Otherwise an error means the old arena was freed but no new one could
+    /// be created: the arena then holds no memory and only deinit() may be
+    /// called on it.
+    pub fn reset(self: *Arena) !void {
+        const zig_alloc = self.zig_alloc;
+        if (zig_alloc.fused) {
+            const fresh = try initWithOptions(zig_alloc.zig_allocator, zig_alloc.options);
+            self.deinit();
+            self.* = fresh;
+            return;
+        }
+        zig_alloc.retaining = true;
+        c.upb_Arena_Free(self.ptr);
+        zig_alloc.retaining = false;
+
+        const arena = if (zig_alloc.initial) |block|
+            c.upb_Arena_Init(block.ptr, block.len, &zig_alloc.upb_alloc)
+        else
+            c.upb_Arena_Init(null, 0, &zig_alloc.upb_alloc);
+        if (arena == null) {
+            zig_alloc.freeRetained();
+            zig_alloc.detached = true;
+            return error.OutOfMemory;
+        }
+        zig_alloc.attach(arena.?);
+        self.ptr = arena.?;
+    }
+
+    /// Free the arena and all allocations made from it. A fused arena's
+    /// memory is freed once every arena it was fused with is freed too.
     pub fn deinit(self: Arena) void {
+        const zig_alloc = self.zig_alloc;
+        if (zig_alloc.detached) {
+            zig_alloc.destroy();
+            return;
+        }
+        const upb_owned = zig_alloc.upb_owned;
         c.upb_Arena_Free(self.ptr);
-        self.allocator.destroy(self.zig_alloc);
+        if (!upb_owned) zig_alloc.destroy();
+    }
+
+    /// Tie the lifetimes of two arenas together so messages allocated from
+    /// either may reference each other: no memory of either is freed until
+    /// both are deinitialized. upb cannot extend the lifetime of a caller's
+    /// first block, so this fails for arenas from initWithBuffer().
+    pub fn fuse(self: Arena, other: Arena) error{ArenaFuseFailed}!void {
+        if (self.ptr == other.ptr) return;
+        if (!c.upb_Arena_Fuse(self.ptr, other.ptr)) return error.ArenaFuseFailed;
+        self.zig_alloc.fused = true;
+        other.zig_alloc.fused = true;
+    }
+
+    /// Report how much memory the arena holds, e.g. to size per-request
+    /// budgets from the cost of a decoded message graph.
+    pub fn stats(self: Arena) ArenaStats {
+        const zig_alloc = self.zig_alloc;
+        var requested: usize = 0;
+        var it = zig_alloc.blocks.iterator();
+        while (it.next()) |block| requested += block.requested;
+
+        var fused_count: usize = 0;
+        const space_allocated = c.upb_Arena_SpaceAllocated(self.ptr, &fused_count);
+        const reserved = zig_alloc.reservedBytes();
+        return .{
+            .requested = requested,
+            .reserved = reserved,
+            .blocks = zig_alloc.blocks.count() + @intFromBool(zig_alloc.initial != null) + @intFromBool(zig_alloc.retained != null),
+            .peak_reserved = @max(zig_alloc.peak_bytes, reserved),
+            .space_allocated = space_allocated,
+            .fused_count = fused_count,
+            .refused = zig_alloc.refused,
+        };
     }
 
     /// Allocate memory from the arena.
@@ -161,6 +585,142 @@ pub const Arena = struct {
     }
 };
 
+/// Recycles arenas across requests through a per-thread idle list, so a
+/// fixed pool of worker threads never contends on the backing allocator in
+/// steady state. Released arenas are reset (keeping their largest block) and
+/// parked on the releasing thread; acquire() takes one from the calling
+/// thread's list before creating a new arena.
+///
+/// Each pool gets its own idle list per thread, keyed by the pool's id, so
+/// high_water_bytes applies to one pool at a time. Copies of a pool share
+/// its id and therefore its idle lists. A thread holds idle lists for at
+/// most max_pools_per_thread pools; releases into further pools destroy
+/// the arena instead of parking it.
+///
+/// Idle lists are threadlocal: call trimThread() on each worker before it
+/// exits, and before deinit of the backing allocator.
+pub const ArenaPool = struct {
+    allocator: std.mem.Allocator,
+    options: Options,
+    id: u32,
+
+    pub const Options = struct {
+        /// Options for the arenas the pool creates.
+        arena: ArenaOptions = .{},
+        /// Idle memory a thread may hold across this pool's arenas. Arenas
+        /// released above this are destroyed instead of parked.
+        high_water_bytes: usize = 4 * 1024 * 1024,
+    };
+
+    pub const max_pools_per_thread = 8;
+
+    /// One thread's idle arenas for one pool; pool_id 0 marks a free slot.
+    const IdleList = struct {
+        pool_id: u32 = 0,
+        head: ?*ZigUpbAlloc = null,
+        bytes: usize = 0,
+    };
+
+    threadlocal var idle_lists: [max_pools_per_thread]IdleList = [_]IdleList{.{}} ** max_pools_per_thread;
+    var next_id = std.atomic.Value(u32).init(1);
+
+    pub fn init(allocator: std.mem.Allocator, options: Options) ArenaPool {
+        return .{
+            .allocator = allocator,
+            .options = options,
+            .id = next_id.fetchAdd(1, .monotonic),
+        };
+    }
+
+    /// This thread's idle list for the pool. With `claim`, takes a free
+    /// slot if the pool has none yet; null if every slot is in use.
+    fn idleList(self: ArenaPool, claim: bool) ?*IdleList {
+        var free: ?*IdleList = null;
+        for (&idle_lists) |*list| {
+            if (list.pool_id == self.id) return list;
+            if (list.pool_id == 0 and free == null) free = list;
+        }
+        if (!claim) return null;
+        const list = free orelse return null;
+        list.pool_id = self.id;
+        return list;
+    }
+
+    /// Take an idle arena from this thread's list, or create one.
+    pub fn acquire(self: ArenaPool) !Arena {
+        if (self.idleList(false)) |list| {
+            if (list.head) |zig_alloc| {
+                list.head = zig_alloc.idle_next;
+                list.bytes -= retainedBytes(zig_alloc);
+                const arena = Arena{
+                    .ptr = zig_alloc.idle_arena.?,
+                    .zig_alloc = zig_alloc,
+                    .allocator = self.allocator,
+                };
+                zig_alloc.idle_next = null;
+                zig_alloc.idle_arena = null;
+                return arena;
+            }
+        }
+        return Arena.initWithOptions(self.allocator, self.options.arena);
+    }
+
+    /// Reset `arena` and park it on this thread's idle list, or destroy it
+    /// if that would take the pool's list above high_water_bytes. Every
+    /// message allocated from it becomes invalid.
+    pub fn release(self: ArenaPool, arena: Arena) void {
+        std.debug.assert(!arena.zig_alloc.in_buffer);
+        var recycled = arena;
+        recycled.reset() catch {
+            arena.deinit();
+            return;
+        };
+        const bytes = retainedBytes(recycled.zig_alloc);
+        const list = self.idleList(true) orelse {
+            recycled.deinit();
+            return;
+        };
+        if (list.bytes + bytes > self.options.high_water_bytes) {
+            if (list.head == null) list.* = .{};
+            recycled.deinit();
+            return;
+        }
+        const zig_alloc = recycled.zig_alloc;
+        zig_alloc.idle_arena = recycled.ptr;
+        zig_alloc.idle_next = list.head;
+        list.head = zig_alloc;
+        list.bytes += bytes;
+    }
+
+    /// Destroy every idle arena this thread holds for the pool and free
+    /// the pool's slot.
+    pub fn trimThread(self: ArenaPool) void {
+        const list = self.idleList(false) orelse return;
+        while (list.head) |zig_alloc| {
+            list.head = zig_alloc.idle_next;
+            const arena = Arena{
+                .ptr = zig_alloc.idle_arena.?,
+                .zig_alloc = zig_alloc,
+                .allocator = self.allocator,
+            };
+            arena.deinit();
+        }
+        list.* = .{};
+    }
+
+    /// Idle bytes this thread holds for the pool.
+    pub fn idleBytes(self: ArenaPool) usize {
+        const list = self.idleList(false) orelse return 0;
+        return list.bytes;
+    }
+
+    /// Bytes an idle arena keeps alive: the block reset() kept as its
+    /// first block.
+    fn retainedBytes(zig_alloc: *const ZigUpbAlloc) usize {
+        return zig_alloc.reservedBytes();
+    }
+};
+
 /// Status for error reporting, wrapping upb_Status.
 pub const Status = struct {
     status: c.upb_Status,
@@ -185,6 +745,35 @@ pub const Status = struct {
     }
 };
 
+// ============================================================================
+// Initialization lock - one-time setup of generated files
+// ============================================================================
+// Generated code publishes each message's MiniTable with a release store and
+// checks it with an acquire load, so accessors never lock once a type is
+// initialized. The first use of a type takes this lock to build and link the
+// tables. It is reentrant on the owning thread because building one file's
+// tables can initialize the files it depends on.
+
+var _init_mutex: std.Thread.Mutex = .{};
+threadlocal var _init_depth: u32 = 0;
+
+/// Acquire the global initialization lock. Reentrant on the calling thread.
+pub fn lockInit() void {
+    if (_init_depth == 0) _init_mutex.lock();
+    _init_depth += 1;
+}
+
+/// Release the global initialization lock.
+pub fn unlockInit() void {
+    _init_depth -= 1;
+    if (_init_depth == 0) _init_mutex.unlock();
+}
+
+// upb_DefPool is not safe to read while a file is being added, so every
+// DefPool operation takes this lock: shared for lookups and JSON, exclusive
+// for addFile.
+var _def_pool_lock: std.Thread.RwLock = .{};
+
 // ============================================================================
 // Definition Pool - for loading descriptors and extracting MiniTables
 // ============================================================================
@@ -210,6 +799,8 @@ pub const DefPool = struct {
     /// This parses the descriptor and makes its messages available.
     /// Silently succeeds if the file is already loaded.
     pub fn addFile(self: DefPool, serialized_descriptor: []const u8) void {
+        _def_pool_lock.lock();
+        defer _def_pool_lock.unlock();
         var status = Status.init();
         _ = c.upb_zig_DefPool_AddFile(
             self.ptr,
@@ -222,25 +813,37 @@ pub const DefPool = struct {
 
     /// Find a message by fully-qualified name (e.g., "package.MessageName").
     pub fn findMessage(self: DefPool, name: [:0]const u8) ?*const c.upb_MessageDef {
+        _def_pool_lock.lockShared();
+        defer _def_pool_lock.unlockShared();
         return c.upb_zig_DefPool_FindMessageByName(self.ptr, name.ptr);
     }
+
+    /// Find an enum by fully-qualified name (e.g., "package.EnumName").
+    pub fn findEnum(self: DefPool, name: [:0]const u8) ?*const c.upb_EnumDef {
+        _def_pool_lock.lockShared();
+        defer _def_pool_lock.unlockShared();
+        return c.upb_zig_DefPool_FindEnumByName(self.ptr, name.ptr);
+    }
 };
 
 // ============================================================================
 // Shared DefPool - global singleton for all proto files in the binary
 // ============================================================================
 
-var _shared_def_pool: ?DefPool = null;
-var _shared_pool_init: bool = false;
+var _shared_def_pool: ?*c.upb_DefPool = null;
 
 /// Get the shared DefPool used by all generated proto files.
-/// Creates the pool on first access.
+/// Creates the pool on first access; safe to call from any thread.
 pub fn sharedDefPool() !DefPool {
-    if (!_shared_pool_init) {
-        _shared_def_pool = try DefPool.init();
-        _shared_pool_init = true;
+    if (@atomicLoad(?*c.upb_DefPool, &_shared_def_pool, .acquire)) |ptr| {
+        return DefPool{ .ptr = ptr };
     }
-    return _shared_def_pool.?;
+    lockInit();
+    defer unlockInit();
+    if (_shared_def_pool) |ptr| return DefPool{ .ptr = ptr };
+    const pool = try DefPool.init();
+    @atomicStore(?*c.upb_DefPool, &_shared_def_pool, pool.ptr, .release);
+    return pool;
 }
 
 /// Get the MiniTable for a message definition.
@@ -248,16 +851,221 @@ pub fn getMessageMiniTable(msg_def: *const c.upb_MessageDef) *const c.upb_MiniTa
     return c.upb_zig_MessageDef_MiniTable(msg_def);
 }
 
+/// upb's own MiniDescriptor for a message definition, allocated from `arena`.
+/// protoc-gen-zig must produce the same string for every message.
+pub fn messageDefMiniDescriptor(arena: Arena, msg_def: *const c.upb_MessageDef) error{OutOfMemory}![]const u8 {
+    var out: c.upb_StringView = undefined;
+    if (!c.upb_zig_MessageDef_MiniDescriptorEncode(msg_def, arena.ptr, &out)) return error.OutOfMemory;
+    return fromStringView(out);
+}
+
+/// upb's own MiniDescriptor for an enum definition, allocated from `arena`.
+pub fn enumDefMiniDescriptor(arena: Arena, enum_def: *const c.upb_EnumDef) error{OutOfMemory}![]const u8 {
+    var out: c.upb_StringView = undefined;
+    if (!c.upb_zig_EnumDef_MiniDescriptorEncode(enum_def, arena.ptr, &out)) return error.OutOfMemory;
+    return fromStringView(out);
+}
+
+/// Whether an enum definition is closed (proto2 semantics).
+pub fn enumDefIsClosed(enum_def: *const c.upb_EnumDef) bool {
+    return c.upb_zig_EnumDef_IsClosed(enum_def);
+}
+
 /// Find a field in a MiniTable by field number.
 pub fn findFieldByNumber(mt: *const c.upb_MiniTable, field_number: u32) ?*const c.upb_MiniTableField {
     return c.upb_zig_MiniTable_FindFieldByNumber(mt, field_number);
 }
 
+// ============================================================================
+// MiniTable construction - building MiniTables from MiniDescriptors
+// ============================================================================
+// protoc-gen-zig encodes a MiniDescriptor for every message and closed enum,
+// so the wire format path never has to parse a FileDescriptorProto. The
+// tables are still decoded from those strings at startup: the generator
+// does not emit static, pre-linked upb_MiniTable structs, since that would
+// mean mirroring upb's private layout rules in Python (see TODO.md).
+
+/// How a generated file builds its MiniTables. Each generated file has a
+/// `minitable_mode` variable (defaulting to the protoc-gen-zig
+/// `minitable_mode` option) that can be set before the file is first used.
+pub const MiniTableMode = enum {
+    /// Load the embedded FileDescriptorProto into the shared DefPool and take
+    /// every MiniTable from its MessageDef.
+    def_pool,
+    /// Build every MiniTable in the file from its MiniDescriptor the first
+    /// time any message in the file is used.
+    eager,
+    /// Build a message's MiniTable, and the tables it links to, the first
+    /// time that message type is used.
+    lazy,
+};
+
+/// Initial block for the MiniTable arena, sized by
+/// Options.minitable_arena_bytes. Only tables past it come from the heap.
+var _minitable_arena_buf: [root_options.minitable_arena_bytes]u8 align(16) = undefined;
+var _minitable_arena: ?*c.upb_Arena = null;
+/// Blocks the MiniTable arena took from the C heap once the static block was
+/// full, counted by miniTableAllocFn.
+var _minitable_heap_bytes: usize = 0;
+var _minitable_alloc: c.upb_alloc = .{ .func = miniTableAllocFn };
+
+/// upb_alloc_global, counting the blocks handed to the MiniTable arena.
+/// The arena is never freed, so only allocations need counting.
+fn miniTableAllocFn(alloc: [*c]c.upb_alloc, ptr: ?*anyopaque, oldsize: usize, size: usize, actual_size: [*c]usize) callconv(.c) ?*anyopaque {
+    _ = alloc;
+    const global = &c.upb_alloc_global;
+    const result = global.func.?(global, ptr, oldsize, size, actual_size);
+    if (ptr == null and result != null) {
+        _minitable_heap_bytes += if (actual_size != null) actual_size.* else size;
+    }
+    return result;
+}
+
+/// Arena that owns every MiniTable built from a MiniDescriptor.
+/// Lives for the rest of the process, like the shared DefPool.
+/// Callers must hold the initialization lock.
+fn miniTableArena() ?*c.upb_Arena {
+    if (_minitable_arena == null) {
+        _minitable_arena = c.upb_Arena_Init(&_minitable_arena_buf, _minitable_arena_buf.len, &_minitable_alloc);
+    }
+    return _minitable_arena;
+}
+
+/// Build an (unlinked) MiniTable from a message MiniDescriptor.
+pub fn buildMiniTable(mini_descriptor: []const u8) ?*c.upb_MiniTable {
+    lockInit();
+    defer unlockInit();
+    const arena = miniTableArena() orelse return null;
+    var status = Status.init();
+    return c.upb_zig_MiniTable_Build(mini_descriptor.ptr, mini_descriptor.len, arena, status.raw());
+}
+
+/// Build a MiniTableEnum from a closed enum's MiniDescriptor.
+pub fn buildMiniTableEnum(mini_descriptor: []const u8) ?*const c.upb_MiniTableEnum {
+    lockInit();
+    defer unlockInit();
+    const arena = miniTableArena() orelse return null;
+    var status = Status.init();
+    return c.upb_zig_MiniTableEnum_Build(mini_descriptor.ptr, mini_descriptor.len, arena, status.raw());
+}
+
+/// Bytes the MiniTable arena has used: the consumed part of its static
+/// block (all of it once the arena has moved on to the heap) plus its heap
+/// blocks.
+pub fn miniTableArenaBytes() usize {
+    lockInit();
+    defer unlockInit();
+    const arena = _minitable_arena orelse return 0;
+    if (_minitable_heap_bytes == 0) {
+        return _minitable_arena_buf.len - c.upb_zig_Arena_Remaining(arena);
+    }
+    return _minitable_arena_buf.len + _minitable_heap_bytes;
+}
+
+/// Bytes the MiniTable arena took from the C heap beyond its static block.
+pub fn miniTableArenaHeapBytes() usize {
+    lockInit();
+    defer unlockInit();
+    return _minitable_heap_bytes;
+}
+
+/// Bytes held by the shared DefPool (def_pool mode tables and JSON
+/// definitions); 0 if it has not been created.
+pub fn sharedDefPoolBytes() usize {
+    const pool = @atomicLoad(?*c.upb_DefPool, &_shared_def_pool, .acquire) orelse return 0;
+    _def_pool_lock.lockShared();
+    defer _def_pool_lock.unlockShared();
+    return c.upb_zig_DefPool_SpaceAllocated(pool);
+}
+
+/// Link sub-message and closed enum tables into a MiniTable.
+/// Both slices are in field number order, as emitted by protoc-gen-zig.
+pub fn linkMiniTable(
+    mt: *c.upb_MiniTable,
+    sub_tables: []const ?*const c.upb_MiniTable,
+    sub_enums: []const ?*const c.upb_MiniTableEnum,
+) bool {
+    return c.upb_zig_MiniTable_Link(
+        mt,
+        @ptrCast(@constCast(sub_tables.ptr)),
+        sub_tables.len,
+        @ptrCast(@constCast(sub_enums.ptr)),
+        sub_enums.len,
+    );
+}
+
+// ============================================================================
+// Warm-up - initializing generated files before they are used
+// ============================================================================
+
+pub const WarmUpOptions = struct {
+    /// Also load descriptors into the shared DefPool for JSON.
+    json: bool = false,
+};
+
+pub const WarmUpStats = struct {
+    /// Generated files warmed up for the first time by this call.
+    files: usize = 0,
+    /// Wall time spent in this call.
+    elapsed_ns: u64 = 0,
+    /// MiniTable arena bytes used by this call, static block included.
+    minitable_bytes: usize = 0,
+    /// Part of `minitable_bytes` that came from the heap.
+    minitable_heap_bytes: usize = 0,
+    /// Bytes added to the shared DefPool by this call: every table in
+    /// def_pool mode, and the JSON definitions when `json` is set.
+    def_pool_bytes: usize = 0,
+};
+
+var _files_warmed_up: usize = 0;
+
+/// Called by generated warmUp() the first time a file is warmed up.
+pub fn noteFileWarmedUp() void {
+    _files_warmed_up += 1;
+}
+
+/// Generated files warmed up so far in this process.
+pub fn filesWarmedUp() usize {
+    lockInit();
+    defer unlockInit();
+    return _files_warmed_up;
+}
+
+/// Initialize every message in the given generated modules and, transitively,
+/// the files they import, e.g. at the top of main():
+///
+///     const stats = upb_zig.warmUpAll(.{ foo_pb, bar_pb }, .{});
+///
+/// Afterwards no message pays for initialization on first use, and the root
+/// module may set `upb_zig_options.assume_warm` to drop the checks entirely.
+pub fn warmUpAll(comptime modules: anytype, warm_up_options: WarmUpOptions) WarmUpStats {
+    lockInit();
+    defer unlockInit();
+
+    const files_before = _files_warmed_up;
+    const bytes_before = miniTableArenaBytes();
+    const heap_before = _minitable_heap_bytes;
+    const def_pool_before = sharedDefPoolBytes();
+    var timer = std.time.Timer.start() catch null;
+
+    inline for (modules) |module| {
+        module.warmUp(warm_up_options);
+    }
+
+    return .{
+        .files = _files_warmed_up - files_before,
+        .elapsed_ns = if (timer) |*t| t.read() else 0,
+        .minitable_bytes = miniTableArenaBytes() - bytes_before,
+        .minitable_heap_bytes = _minitable_heap_bytes - heap_before,
+        .def_pool_bytes = sharedDefPoolBytes() - def_pool_before,
+    };
+}
+
 // ============================================================================
 // JSON Encoding/Decoding
 // ============================================================================
 
-pub const JsonDecodeError = error{JsonDecodeFailed};
+pub const JsonDecodeError = error{ JsonDecodeFailed, ArenaBudgetExceeded };
 pub const JsonEncodeError = error{JsonEncodeFailed};
 
 /// JSON encode options
@@ -295,7 +1103,10 @@ pub fn jsonDecode(
     arena: Arena,
     options: JsonDecodeOptions,
 ) JsonDecodeError!void {
+    _def_pool_lock.lockShared();
+    defer _def_pool_lock.unlockShared();
     var status = Status.init();
+    const refused = arena.zig_alloc.refused;
     const ok = c.upb_zig_JsonDecode(
         json_data.ptr,
         json_data.len,
@@ -307,6 +1118,7 @@ pub fn jsonDecode(
         status.raw(),
     );
     if (!ok) {
+        if (arena.zig_alloc.refused != refused) return JsonDecodeError.ArenaBudgetExceeded;
         return JsonDecodeError.JsonDecodeFailed;
     }
 }
@@ -320,6 +1132,8 @@ pub fn jsonEncode(
     arena: Arena,
     options: JsonEncodeOptions,
 ) JsonEncodeError![]const u8 {
+    _def_pool_lock.lockShared();
+    defer _def_pool_lock.unlockShared();
     var status = Status.init();
 
     // First call to get required size
@@ -392,37 +1206,129 @@ pub fn messageNew(mini_table: *const c.upb_MiniTable, arena: Arena) ?*c.upb_Mess
     return c.upb_Message_New(mini_table, arena.ptr);
 }
 
+// --- Native field access ---
+// Inlinable Zig versions of upb's base field accessors
+// (upb/message/internal/accessors.h). Only used for non-extension scalar and
+// string fields, which is all generated code passes here.
+
+/// Mirror of upb's `struct upb_MiniTableField` (upb/mini_table/internal/field.h).
+const FieldLayout = extern struct {
+    number: u32,
+    offset: u16,
+    /// >0: hasbit index, <0: ~offset of the oneof case, 0: no presence.
+    presence: i16,
+    submsg_index: u16,
+    descriptortype: u8,
+    mode: u8,
+};
+
+// Field by field, so a reordering of same-sized fields in a upb update is
+// caught too. upb mangles its private names to
+// `<name>_dont_copy_me__upb_internal_use_only`, hence the prefix match.
+comptime {
+    const mirror = @typeInfo(FieldLayout).@"struct".fields;
+    const upb = @typeInfo(c.upb_MiniTableField).@"struct".fields;
+    if (@sizeOf(FieldLayout) != @sizeOf(c.upb_MiniTableField) or mirror.len != upb.len) {
+        @compileError("FieldLayout does not match upb_MiniTableField");
+    }
+    for (mirror, upb) |m, u| {
+        if (!std.mem.startsWith(u8, u.name, m.name) or
+            @offsetOf(FieldLayout, m.name) != @offsetOf(c.upb_MiniTableField, u.name) or
+            @sizeOf(m.type) != @sizeOf(u.type))
+        {
+            @compileError("FieldLayout." ++ m.name ++ " does not match upb_MiniTableField." ++ u.name);
+        }
+    }
+}
+
+inline fn fieldLayout(field: *const c.upb_MiniTableField) *const FieldLayout {
+    return @ptrCast(@alignCast(field));
+}
+
+/// Same test as upb's _upb_MiniTableField_DataIsZero.
+inline fn isZeroValue(comptime T: type, value: T) bool {
+    if (T == c.upb_StringView) return value.size == 0;
+    return std.mem.allEqual(u8, std.mem.asBytes(&value), 0);
+}
+
+inline fn nativeHas(base: [*]const u8, f: *const FieldLayout) bool {
+    if (f.presence > 0) {
+        const index: usize = @intCast(f.presence);
+        return base[index / 8] & (@as(u8, 1) << @intCast(index % 8)) != 0;
+    }
+    const case: *const u32 = @ptrCast(@alignCast(base + @as(usize, @intCast(~f.presence))));
+    return case.* == f.number;
+}
+
+/// Equivalent of upb_Message_GetBaseField: oneof members and fields with a
+/// non-zero default return the default unless present.
+inline fn nativeGet(comptime T: type, msg: *const c.upb_Message, field: *const c.upb_MiniTableField, default: T) T {
+    const f = fieldLayout(field);
+    const base: [*]const u8 = @ptrCast(msg);
+    if (f.presence != 0 and (f.presence < 0 or !isZeroValue(T, default)) and !nativeHas(base, f)) {
+        return default;
+    }
+    const data: *const T = @ptrCast(@alignCast(base + f.offset));
+    return data.*;
+}
+
+/// Equivalent of upb_Message_SetBaseField: marks the field present, then stores.
+inline fn nativeSet(comptime T: type, msg: *c.upb_Message, field: *const c.upb_MiniTableField, value: T) void {
+    const f = fieldLayout(field);
+    const base: [*]u8 = @ptrCast(msg);
+    if (f.presence > 0) {
+        const index: usize = @intCast(f.presence);
+        base[index / 8] |= @as(u8, 1) << @intCast(index % 8);
+    } else if (f.presence < 0) {
+        const case: *u32 = @ptrCast(@alignCast(base + @as(usize, @intCast(~f.presence))));
+        case.* = f.number;
+    }
+    const data: *T = @ptrCast(@alignCast(base + f.offset));
+    data.* = value;
+}
+
+const native = root_options.native_accessors;
+
 // --- Scalar Field Getters ---
 
 pub fn getBool(msg: *const c.upb_Message, field: *const c.upb_MiniTableField, default: bool) bool {
+    // upb stores bools as a single byte
+    if (native) return nativeGet(u8, msg, field, @intFromBool(default)) != 0;
     return c.upb_zig_Message_GetBool(msg, field, default);
 }
 
 pub fn getInt32(msg: *const c.upb_Message, field: *const c.upb_MiniTableField, default: i32) i32 {
+    if (native) return nativeGet(i32, msg, field, default);
     return c.upb_zig_Message_GetInt32(msg, field, default);
 }
 
 pub fn getInt64(msg: *const c.upb_Message, field: *const c.upb_MiniTableField, default: i64) i64 {
+    if (native) return nativeGet(i64, msg, field, default);
     return c.upb_zig_Message_GetInt64(msg, field, default);
 }
 
 pub fn getUInt32(msg: *const c.upb_Message, field: *const c.upb_MiniTableField, default: u32) u32 {
+    if (native) return nativeGet(u32, msg, field, default);
     return c.upb_zig_Message_GetUInt32(msg, field, default);
 }
 
 pub fn getUInt64(msg: *const c.upb_Message, field: *const c.upb_MiniTableField, default: u64) u64 {
+    if (native) return nativeGet(u64, msg, field, default);
     return c.upb_zig_Message_GetUInt64(msg, field, default);
 }
 
 pub fn getFloat(msg: *const c.upb_Message, field: *const c.upb_MiniTableField, default: f32) f32 {
+    if (native) return nativeGet(f32, msg, field, default);
     return c.upb_zig_Message_GetFloat(msg, field, default);
 }
 
 pub fn getDouble(msg: *const c.upb_Message, field: *const c.upb_MiniTableField, default: f64) f64 {
+    if (native) return nativeGet(f64, msg, field, default);
     return c.upb_zig_Message_GetDouble(msg, field, default);
 }
 
 pub fn getString(msg: *const c.upb_Message, field: *const c.upb_MiniTableField, default: []const u8) []const u8 {
+    if (native) return fromStringView(nativeGet(c.upb_StringView, msg, field, toStringView(default)));
     const sv = c.upb_zig_Message_GetString(msg, field, toStringView(default));
     return fromStringView(sv);
 }
@@ -430,34 +1336,42 @@ pub fn getString(msg: *const c.upb_Message, field: *const c.upb_MiniTableField,
 // --- Scalar Field Setters ---
 
 pub fn setBool(msg: *c.upb_Message, field: *const c.upb_MiniTableField, value: bool) void {
+    if (native) return nativeSet(u8, msg, field, @intFromBool(value));
     c.upb_zig_Message_SetBool(msg, field, value);
 }
 
 pub fn setInt32(msg: *c.upb_Message, field: *const c.upb_MiniTableField, value: i32) void {
+    if (native) return nativeSet(i32, msg, field, value);
     c.upb_zig_Message_SetInt32(msg, field, value);
 }
 
 pub fn setInt64(msg: *c.upb_Message, field: *const c.upb_MiniTableField, value: i64) void {
+    if (native) return nativeSet(i64, msg, field, value);
     c.upb_zig_Message_SetInt64(msg, field, value);
 }
 
 pub fn setUInt32(msg: *c.upb_Message, field: *const c.upb_MiniTableField, value: u32) void {
+    if (native) return nativeSet(u32, msg, field, value);
     c.upb_zig_Message_SetUInt32(msg, field, value);
 }
 
 pub fn setUInt64(msg: *c.upb_Message, field: *const c.upb_MiniTableField, value: u64) void {
+    if (native) return nativeSet(u64, msg, field, value);
     c.upb_zig_Message_SetUInt64(msg, field, value);
 }
 
 pub fn setFloat(msg: *c.upb_Message, field: *const c.upb_MiniTableField, value: f32) void {
+    if (native) return nativeSet(f32, msg, field, value);
     c.upb_zig_Message_SetFloat(msg, field, value);
 }
 
 pub fn setDouble(msg: *c.upb_Message, field: *const c.upb_MiniTableField, value: f64) void {
+    if (native) return nativeSet(f64, msg, field, value);
     c.upb_zig_Message_SetDouble(msg, field, value);
 }
 
 pub fn setString(msg: *c.upb_Message, field: *const c.upb_MiniTableField, value: []const u8) void {
+    if (native) return nativeSet(c.upb_StringView, msg, field, toStringView(value));
     c.upb_zig_Message_SetString(msg, field, toStringView(value), null);
 }
 
@@ -465,6 +1379,7 @@ pub fn setString(msg: *c.upb_Message, field: *const c.upb_MiniTableField, value:
 
 /// Check if a field is set on a message. Works for oneof members, optional fields, etc.
 pub fn hasField(msg: *const c.upb_Message, field: *const c.upb_MiniTableField) bool {
+    if (native and fieldLayout(field).presence != 0) return nativeHas(@ptrCast(msg), fieldLayout(field));
     return c.upb_zig_Message_HasField(msg, field);
 }
 
@@ -477,6 +1392,19 @@ pub fn getArrayLen(msg: *const c.upb_Message, field: *const c.upb_MiniTableField
     return c.upb_zig_Array_Size(arr);
 }
 
+/// View the elements of a repeated numeric, bool or enum (as i32) field
+/// in place, without a C call per element. The slice points at the array's
+/// storage in the message's arena, and its length is fixed at the call.
+/// Writes through arraySet() show through it. An append that grows the
+/// array moves the elements, and the slice keeps showing the old copy.
+pub fn arraySlice(comptime T: type, msg: *const c.upb_Message, field: *const c.upb_MiniTableField) []const T {
+    const arr = c.upb_zig_Message_GetArray(msg, field) orelse return &.{};
+    const len = c.upb_zig_Array_Size(arr);
+    if (len == 0) return &.{};
+    const data: [*]const T = @ptrCast(@alignCast(c.upb_zig_Array_DataPtr(arr)));
+    return data[0..len];
+}
+
 // Array element getters - take (msg, field, index), return the element value.
 // Returns default if the array is null.
 
@@ -584,6 +1512,207 @@ pub fn arrayAppendMessage(msg: *c.upb_Message, field: *const c.upb_MiniTableFiel
     if (!c.upb_zig_Array_AppendMessage(arr, value, arena.ptr)) return error.OutOfMemory;
 }
 
+/// Append a new empty message to a repeated message field of a message
+/// described by `mini_table`, and return it for the caller to fill in.
+pub fn arrayAppendNewMessage(msg: *c.upb_Message, mini_table: *const c.upb_MiniTable, field: *const c.upb_MiniTableField, arena: Arena) !*c.upb_Message {
+    const sub_mt = c.upb_zig_MiniTable_GetSubMessageTable(mini_table, field) orelse return error.OutOfMemory;
+    const arr = c.upb_zig_Message_GetOrCreateMutableArray(msg, field, arena.ptr) orelse return error.OutOfMemory;
+    const len = c.upb_zig_Array_Size(arr);
+    if (!c.upb_zig_Array_Resize(arr, len + 1, arena.ptr)) return error.OutOfMemory;
+    const sub = c.upb_Message_New(sub_mt, arena.ptr) orelse {
+        _ = c.upb_zig_Array_Resize(arr, len, arena.ptr);
+        return error.OutOfMemory;
+    };
+    arrayData(*c.upb_Message, arr)[len] = sub;
+    return sub;
+}
+
+// Bulk array operations - one resize and one copy instead of a C call and
+// possible reallocation per element.
+
+/// Make room for `additional` more elements in a repeated field, so the
+/// appends that follow don't reallocate.
+pub fn arrayReserve(msg: *c.upb_Message, field: *const c.upb_MiniTableField, additional: usize, arena: Arena) !void {
+    const arr = c.upb_zig_Message_GetOrCreateMutableArray(msg, field, arena.ptr) orelse return error.OutOfMemory;
+    if (!c.upb_zig_Array_Reserve(arr, c.upb_zig_Array_Size(arr) + additional, arena.ptr)) return error.OutOfMemory;
+}
+
+/// Append `values` to a repeated numeric, bool, enum (as an enum(i32)) or
+/// string field. Strings are stored as views, like arrayAppendString.
+pub fn arrayAppendSlice(comptime T: type, msg: *c.upb_Message, field: *const c.upb_MiniTableField, values: []const T, arena: Arena) !void {
+    const arr = c.upb_zig_Message_GetOrCreateMutableArray(msg, field, arena.ptr) orelse return error.OutOfMemory;
+    try arrayWriteSlice(T, arr, c.upb_zig_Array_Size(arr), values, arena);
+}
+
+/// Replace the elements of a repeated field with `values`; see arrayAppendSlice.
+pub fn arraySetSlice(comptime T: type, msg: *c.upb_Message, field: *const c.upb_MiniTableField, values: []const T, arena: Arena) !void {
+    const arr = c.upb_zig_Message_GetOrCreateMutableArray(msg, field, arena.ptr) orelse return error.OutOfMemory;
+    try arrayWriteSlice(T, arr, 0, values, arena);
+}
+
+fn arrayWriteSlice(comptime T: type, arr: *c.upb_Array, start: usize, values: []const T, arena: Arena) !void {
+    if (!c.upb_zig_Array_Resize(arr, start + values.len, arena.ptr)) return error.OutOfMemory;
+    if (values.len == 0) return;
+    const dest = arrayData(T, arr)[start..][0..values.len];
+    if (T == []const u8) {
+        for (dest, values) |*d, v| d.* = toStringView(v);
+    } else {
+        @memcpy(dest, values);
+    }
+}
+
+/// How upb stores an element of a repeated field accessed as T.
+fn ArrayElem(comptime T: type) type {
+    return if (T == []const u8) c.upb_StringView else T;
+}
+
+fn arrayData(comptime T: type, arr: *c.upb_Array) [*]ArrayElem(T) {
+    return @ptrCast(@alignCast(c.upb_zig_Array_MutableDataPtr(arr)));
+}
+
+// In-place array mutation. T is the element type as for arrayAppendSlice,
+// or *upb_Message for repeated message fields. The element storage is
+// written directly, as upb_Array_Set does.
+
+/// Overwrite element `index` of a repeated field.
+pub fn arraySet(comptime T: type, msg: *c.upb_Message, field: *const c.upb_MiniTableField, index: usize, value: T) error{IndexOutOfBounds}!void {
+    const arr = c.upb_zig_Message_GetMutableArray(msg, field) orelse return error.IndexOutOfBounds;
+    if (index >= c.upb_zig_Array_Size(arr)) return error.IndexOutOfBounds;
+    arrayData(T, arr)[index] = if (T == []const u8) toStringView(value) else value;
+}
+
+/// Shorten a repeated field to at most `len` elements.
+pub fn arrayTruncate(msg: *c.upb_Message, field: *const c.upb_MiniTableField, len: usize, arena: Arena) void {
+    const arr = c.upb_zig_Message_GetMutableArray(msg, field) orelse return;
+    if (len >= c.upb_zig_Array_Size(arr)) return;
+    // Shrinking never allocates, so it cannot fail.
+    _ = c.upb_zig_Array_Resize(arr, len, arena.ptr);
+}
+
+/// Remove element `index` of a repeated field in O(1) by moving the last
+/// element into its place.
+pub fn arraySwapRemove(comptime T: type, msg: *c.upb_Message, field: *const c.upb_MiniTableField, index: usize, arena: Arena) error{IndexOutOfBounds}!void {
+    const arr = c.upb_zig_Message_GetMutableArray(msg, field) orelse return error.IndexOutOfBounds;
+    const len = c.upb_zig_Array_Size(arr);
+    if (index >= len) return error.IndexOutOfBounds;
+    const data = arrayData(T, arr);
+    data[index] = data[len - 1];
+    _ = c.upb_zig_Array_Resize(arr, len - 1, arena.ptr);
+}
+
+// --- Map Operations ---
+//
+// K is the key type (bool, an integer type or []const u8) and V the value
+// type (those, f32, f64, or *upb_Message). Enum values are accessed as i32.
+
+fn toMessageValue(comptime T: type, value: T) c.upb_MessageValue {
+    var v = std.mem.zeroes(c.upb_MessageValue);
+    switch (T) {
+        bool => v.bool_val = value,
+        i32 => v.int32_val = value,
+        i64 => v.int64_val = value,
+        u32 => v.uint32_val = value,
+        u64 => v.uint64_val = value,
+        f32 => v.float_val = value,
+        f64 => v.double_val = value,
+        []const u8 => v.str_val = toStringView(value),
+        *c.upb_Message => v.msg_val = value,
+        else => @compileError("unsupported map type " ++ @typeName(T)),
+    }
+    return v;
+}
+
+fn fromMessageValue(comptime T: type, v: c.upb_MessageValue) T {
+    return switch (T) {
+        bool => v.bool_val,
+        i32 => v.int32_val,
+        i64 => v.int64_val,
+        u32 => v.uint32_val,
+        u64 => v.uint64_val,
+        f32 => v.float_val,
+        f64 => v.double_val,
+        []const u8 => fromStringView(v.str_val),
+        *c.upb_Message => @constCast(v.msg_val.?),
+        else => @compileError("unsupported map type " ++ @typeName(T)),
+    };
+}
+
+/// Get the number of entries in a map field.
+pub fn mapCount(msg: *const c.upb_Message, field: *const c.upb_MiniTableField) usize {
+    const map = c.upb_zig_Message_GetMap(msg, field) orelse return 0;
+    return c.upb_zig_Map_Size(map);
+}
+
+/// Look up `key` in a map field. Returns null if absent.
+pub fn mapGet(comptime K: type, comptime V: type, msg: *const c.upb_Message, field: *const c.upb_MiniTableField, key: K) ?V {
+    const map = c.upb_zig_Message_GetMap(msg, field) orelse return null;
+    const k = toMessageValue(K, key);
+    var v: c.upb_MessageValue = undefined;
+    if (!c.upb_zig_Map_Get(map, &k, &v)) return null;
+    return fromMessageValue(V, v);
+}
+
+/// Insert or replace the entry for `key` in a map field of a message
+/// described by `mini_table`. String keys and values are stored as views,
+/// like setString.
+pub fn mapPut(
+    comptime K: type,
+    comptime V: type,
+    msg: *c.upb_Message,
+    mini_table: *const c.upb_MiniTable,
+    field: *const c.upb_MiniTableField,
+    key: K,
+    value: V,
+    arena: Arena,
+) !void {
+    const entry_mt = c.upb_zig_MiniTable_GetSubMessageTable(mini_table, field) orelse return error.OutOfMemory;
+    const map = c.upb_zig_Message_GetOrCreateMutableMap(msg, entry_mt, field, arena.ptr) orelse return error.OutOfMemory;
+    const k = toMessageValue(K, key);
+    const v = toMessageValue(V, value);
+    if (!c.upb_zig_Map_Set(map, &k, &v, arena.ptr)) return error.OutOfMemory;
+}
+
+/// Remove the entry for `key` from a map field. Returns whether it was present.
+pub fn mapRemove(comptime K: type, msg: *c.upb_Message, field: *const c.upb_MiniTableField, key: K) bool {
+    const map = c.upb_zig_Message_GetMutableMap(msg, field) orelse return false;
+    const k = toMessageValue(K, key);
+    return c.upb_zig_Map_Delete(map, &k);
+}
+
+/// Remove every entry from a map field.
+pub fn mapClear(msg: *c.upb_Message, field: *const c.upb_MiniTableField) void {
+    const map = c.upb_zig_Message_GetMutableMap(msg, field) orelse return;
+    c.upb_zig_Map_Clear(map);
+}
+
+/// Iterates a map field's entries in unspecified order. Putting or removing
+/// entries mid-iteration can rehash the table, after which next() may skip
+/// or repeat entries.
+pub fn MapIterator(comptime K: type, comptime V: type) type {
+    return struct {
+        map: ?*const c.upb_Map,
+        iter: usize = map_begin,
+
+        const Self = @This();
+        /// kUpb_Map_Begin
+        const map_begin: usize = std.math.maxInt(usize);
+
+        pub const Entry = struct { key: K, value: V };
+
+        pub fn next(self: *Self) ?Entry {
+            const map = self.map orelse return null;
+            var k: c.upb_MessageValue = undefined;
+            var v: c.upb_MessageValue = undefined;
+            if (!c.upb_zig_Map_Next(map, &k, &v, &self.iter)) return null;
+            return .{ .key = fromMessageValue(K, k), .value = fromMessageValue(V, v) };
+        }
+    };
+}
+
+pub fn mapIterator(comptime K: type, comptime V: type, msg: *const c.upb_Message, field: *const c.upb_MiniTableField) MapIterator(K, V) {
+    return .{ .map = c.upb_zig_Message_GetMap(msg, field) };
+}
+
 // --- Sub-message (nested message) Operations ---
 
 /// Get a sub-message from a message field. Returns null if not set.
@@ -598,36 +1727,246 @@ pub fn setMessage(msg: *c.upb_Message, field: *const c.upb_MiniTableField, sub_m
     c.upb_zig_Message_SetMessage(msg, field, sub_msg);
 }
 
+/// Get the sub-message on a message field of a message described by
+/// `mini_table`, creating an empty one if it is not set.
+pub fn getOrCreateMessage(msg: *c.upb_Message, mini_table: *const c.upb_MiniTable, field: *const c.upb_MiniTableField, arena: Arena) !*c.upb_Message {
+    return c.upb_zig_Message_GetOrCreateMutableMessage(msg, mini_table, field, arena.ptr) orelse error.OutOfMemory;
+}
+
+/// Make `sub_msg`, allocated from `from`, safe to store in a message
+/// allocated from `into` by fusing the two arenas. Fails if they cannot be
+/// fused: arenas from initWithBuffer never fuse. cloneMessage() into `into` first in that case.
+/// Generated setters call this.
+pub fn adoptMessage(into: Arena, from: Arena, sub_msg: *c.upb_Message) error{ArenaFuseFailed}!*c.upb_Message {
+    if (into.ptr == from.ptr) return sub_msg;
+    try into.fuse(from);
+    return sub_msg;
+}
+
+/// Deep-copy `msg`, described by `mini_table`, into `arena`.
+pub fn cloneMessage(msg: *const c.upb_Message, mini_table: *const c.upb_MiniTable, arena: Arena) error{OutOfMemory}!*c.upb_Message {
+    return c.upb_zig_Message_DeepClone(msg, mini_table, arena.ptr) orelse error.OutOfMemory;
+}
+
 // --- Encode/Decode ---
 
 pub const EncodeError = error{EncodeFailed};
-pub const DecodeError = error{DecodeFailed};
+pub const DecodeError = error{ DecodeFailed, ArenaBudgetExceeded, MissingRequired, MaxDepthExceeded };
+
+/// Wire format encode options
+pub const EncodeOptions = struct {
+    /// Write map entries in sorted key order, so equal messages encode to
+    /// equal bytes (e.g. for content hashing). Only stable within one build.
+    deterministic: bool = false,
+    /// Leave out unknown fields.
+    skip_unknown: bool = false,
+
+    fn toInt(self: EncodeOptions) c_int {
+        var opts: c_int = 0;
+        if (self.deterministic) opts |= c.kUpb_EncodeOption_Deterministic;
+        if (self.skip_unknown) opts |= c.kUpb_EncodeOption_SkipUnknown;
+        return opts;
+    }
+};
 
 /// Encode a message to wire format bytes.
-/// Returns a slice allocated from the arena.
+/// Returns a slice allocated from the arena. upb's encoder can neither size
+/// a message without encoding it nor write into an external buffer, so to
+/// keep encodings out of a long-lived message's arena, encode into a scratch
+/// arena and reset it once the bytes have been sent.
 pub fn encode(msg: *const c.upb_Message, mini_table: *const c.upb_MiniTable, arena: Arena) EncodeError![]const u8 {
+    return encodeWithOptions(msg, mini_table, arena, .{});
+}
+
+/// Encode a message to wire format bytes with explicit options.
+/// Returns a slice allocated from the arena.
+pub fn encodeWithOptions(msg: *const c.upb_Message, mini_table: *const c.upb_MiniTable, arena: Arena, options: EncodeOptions) EncodeError![]const u8 {
     var size: usize = 0;
     var buf: [*c]u8 = undefined;
-    const status = c.upb_Encode(msg, mini_table, 0, arena.ptr, &buf, &size);
+    const status = c.upb_Encode(msg, mini_table, options.toInt(), arena.ptr, &buf, &size);
     if (status != c.kUpb_EncodeStatus_Ok or buf == null) {
         return EncodeError.EncodeFailed;
     }
     return buf[0..size];
 }
 
+pub const EncodeToError = EncodeError || std.Io.Writer.Error || error{OutOfMemory};
+
+/// Fields encodeTo() writes element by element: repeated messages, strings
+/// and bytes, which is where large payloads live.
+fn isStreamedField(field: *const c.upb_MiniTableField) bool {
+    if (!c.upb_zig_MiniTableField_IsArray(field)) return false;
+    return switch (c.upb_zig_MiniTableField_Type(field)) {
+        c.kUpb_FieldType_Message, c.kUpb_FieldType_String, c.kUpb_FieldType_Bytes => true,
+        else => false,
+    };
+}
+
+fn writeLengthDelimited(writer: *std.Io.Writer, number: u32, bytes: []const u8) std.Io.Writer.Error!void {
+    try writer.writeUleb128((@as(u64, number) << 3) | 2);
+    try writer.writeUleb128(bytes.len);
+    try writer.writeAll(bytes);
+}
+
+/// Encode a message to `writer`, streaming its top-level repeated message,
+/// string and bytes fields one element at a time. Everything else is
+/// encoded in one piece from a shallow copy with those fields cleared and
+/// written first. This includes singular strings and sub-messages, packed
+/// scalars, maps, and repeated fields nested inside sub-messages. Peak
+/// memory is bounded by that remainder plus the largest streamed element,
+/// not by the whole message.
+///
+/// Field order differs from encode(): streamed fields come last. Parsers
+/// accept any order, but the bytes are not comparable with encode()'s,
+/// e.g. as a cache key.
+///
+/// Encodings are allocated from `scratch`, which is reset between
+/// elements and must not be the arena that owns `msg`.
+pub fn encodeTo(msg: *const c.upb_Message, mini_table: *const c.upb_MiniTable, scratch: *Arena, writer: *std.Io.Writer) EncodeToError!void {
+    const field_count: u32 = @intCast(c.upb_zig_MiniTable_FieldCount(mini_table));
+
+    const rest = c.upb_zig_Message_ShallowClone(msg, mini_table, scratch.ptr) orelse return EncodeError.EncodeFailed;
+    for (0..field_count) |i| {
+        const field = c.upb_zig_MiniTable_GetFieldByIndex(mini_table, @intCast(i));
+        if (isStreamedField(field)) c.upb_zig_Message_ClearBaseField(rest, field);
+    }
+    try writer.writeAll(try encode(rest, mini_table, scratch.*));
+
+    for (0..field_count) |i| {
+        const field = c.upb_zig_MiniTable_GetFieldByIndex(mini_table, @intCast(i));
+        if (!isStreamedField(field)) continue;
+        const arr = c.upb_zig_Message_GetArray(msg, field) orelse continue;
+        const number = c.upb_zig_MiniTableField_Number(field);
+        switch (c.upb_zig_MiniTableField_Type(field)) {
+            c.kUpb_FieldType_Message => {
+                const sub = c.upb_zig_MiniTable_GetSubMessageTable(mini_table, field) orelse return EncodeError.EncodeFailed;
+                for (0..c.upb_zig_Array_Size(arr)) |j| {
+                    // Only one element's encoding is held at a time.
+                    try scratch.reset();
+                    const element = c.upb_zig_Array_GetMessage(arr, j) orelse return EncodeError.EncodeFailed;
+                    try writeLengthDelimited(writer, number, try encode(element, sub, scratch.*));
+                }
+            },
+            else => for (0..c.upb_zig_Array_Size(arr)) |j| {
+                try writeLengthDelimited(writer, number, fromStringView(c.upb_zig_Array_GetString(arr, j)));
+            },
+        }
+    }
+}
+
+/// Wire format decode options
+pub const DecodeOptions = struct {
+    /// Point string and bytes fields (and unknown fields) into the input
+    /// instead of copying them into the arena. The input must then stay
+    /// valid and unmodified for as long as the arena, and any arena fused
+    /// with it, is alive.
+    alias_string: bool = false,
+    /// Deepest sub-message nesting accepted before failing with
+    /// error.MaxDepthExceeded; null keeps upb's default of 100.
+    max_depth: ?u16 = null,
+    /// Fail with error.MissingRequired if a required field is absent.
+    check_required: bool = false,
+    /// Drop unknown fields (e.g. from newer clients) from the decoded
+    /// message, its sub-messages and message-valued map entries, so they
+    /// are not re-encoded. This runs after the parse, which has already
+    /// recorded them: only with `alias_string` set do their bytes stay out
+    /// of the arena. Without it they are copied in and stay allocated until
+    /// the arena is freed.
+    discard_unknown: bool = false,
+
+    fn toInt(self: DecodeOptions) c_int {
+        var opts: c_int = 0;
+        if (self.alias_string) opts |= c.kUpb_DecodeOption_AliasString;
+        if (self.check_required) opts |= c.kUpb_DecodeOption_CheckRequired;
+        // upb_DecodeOptions_MaxDepth: the limit lives in the upper 16 bits.
+        if (self.max_depth) |depth| opts |= @bitCast(@as(u32, depth) << 16);
+        return opts;
+    }
+};
+
+/// Drop unknown fields from `msg` and the sub-messages it holds, including
+/// map values, up to `depth` levels down.
+fn discardUnknown(msg: *c.upb_Message, mini_table: *const c.upb_MiniTable, depth: u32) void {
+    c.upb_zig_Message_DiscardUnknownShallow(msg);
+    if (depth == 0) return;
+    const field_count: u32 = @intCast(c.upb_zig_MiniTable_FieldCount(mini_table));
+    for (0..field_count) |i| {
+        const field = c.upb_zig_MiniTable_GetFieldByIndex(mini_table, @intCast(i));
+        switch (c.upb_zig_MiniTableField_Type(field)) {
+            c.kUpb_FieldType_Message, c.kUpb_FieldType_Group => {},
+            else => continue,
+        }
+        const sub_mt = c.upb_zig_MiniTable_GetSubMessageTable(mini_table, field) orelse continue;
+        if (c.upb_zig_MiniTableField_IsMap(field)) {
+            discardUnknownInMap(msg, field, sub_mt, depth - 1);
+        } else if (c.upb_zig_MiniTableField_IsArray(field)) {
+            const arr = c.upb_zig_Message_GetArray(msg, field) orelse continue;
+            for (0..c.upb_zig_Array_Size(arr)) |j| {
+                const sub = c.upb_zig_Array_GetMessage(arr, j) orelse continue;
+                discardUnknown(@constCast(sub), sub_mt, depth - 1);
+            }
+        } else if (getMessage(msg, field)) |sub| {
+            discardUnknown(sub, sub_mt, depth - 1);
+        }
+    }
+}
+
+/// discardUnknown() for the values of a map field whose entries are
+/// described by `entry_mt`; maps with scalar values have nothing to drop.
+fn discardUnknownInMap(msg: *c.upb_Message, field: *const c.upb_MiniTableField, entry_mt: *const c.upb_MiniTable, depth: u32) void {
+    const value_field = findFieldByNumber(entry_mt, 2) orelse return;
+    if (c.upb_zig_MiniTableField_Type(value_field) != c.kUpb_FieldType_Message) return;
+    const value_mt = c.upb_zig_MiniTable_GetSubMessageTable(entry_mt, value_field) orelse return;
+    const map = c.upb_zig_Message_GetMap(msg, field) orelse return;
+    var iter: usize = MapIterator(void, void).map_begin;
+    var key: c.upb_MessageValue = undefined;
+    var value: c.upb_MessageValue = undefined;
+    while (c.upb_zig_Map_Next(map, &key, &value, &iter)) {
+        discardUnknown(@constCast(value.msg_val.?), value_mt, depth);
+    }
+}
+
 /// Decode wire format bytes into a message.
 /// The message must already be created via messageNew().
 pub fn decode(msg: *c.upb_Message, mini_table: *const c.upb_MiniTable, data: []const u8, arena: Arena) DecodeError!void {
-    const status = c.upb_Decode(data.ptr, data.len, msg, mini_table, null, 0, arena.ptr);
-    if (status != c.kUpb_DecodeStatus_Ok) {
-        return DecodeError.DecodeFailed;
+    return decodeWithOptions(msg, mini_table, data, arena, .{});
+}
+
+/// Decode wire format bytes into a message with explicit options.
+pub fn decodeWithOptions(
+    msg: *c.upb_Message,
+    mini_table: *const c.upb_MiniTable,
+    data: []const u8,
+    arena: Arena,
+    options: DecodeOptions,
+) DecodeError!void {
+    const refused = arena.zig_alloc.refused;
+    const status = c.upb_Decode(data.ptr, data.len, msg, mini_table, null, options.toInt(), arena.ptr);
+    switch (status) {
+        c.kUpb_DecodeStatus_Ok => {},
+        c.kUpb_DecodeStatus_MissingRequired => return DecodeError.MissingRequired,
+        c.kUpb_DecodeStatus_MaxDepthExceeded => return DecodeError.MaxDepthExceeded,
+        else => {
+            if (status == c.kUpb_DecodeStatus_OutOfMemory and arena.zig_alloc.refused != refused) {
+                return DecodeError.ArenaBudgetExceeded;
+            }
+            return DecodeError.DecodeFailed;
+        },
     }
+    if (options.discard_unknown) discardUnknown(msg, mini_table, options.max_depth orelse 100);
 }
 
 // ============================================================================
 // Tests
 // ============================================================================
 
+/// MiniTable for the proto2 message most tests use:
+///   optional int32 a = 1; optional double b = 2; optional string c = 3;
+///   optional bool d = 4; oneof o { int64 e = 5; float f = 6; }
+fn testMiniTable() !*c.upb_MiniTable {
+    return buildMiniTable("$( 1/+!^&|(") orelse error.BuildFailed;
+}
+
 test "Arena: create and destroy" {
     const arena = try Arena.init(std.testing.allocator);
     defer arena.deinit();
@@ -702,3 +2041,582 @@ test "Arena: with FixedBufferAllocator" {
     const buf_end = buf_start + buffer.len;
     try std.testing.expect(mem_addr >= buf_start and mem_addr < buf_end);
 }
+
+test "Arena: min_block_size rounds blocks up" {
+    // std.testing.allocator also checks that every block is freed at its
+    // recorded size.
+    const arena = try Arena.initWithOptions(std.testing.allocator, .{ .min_block_size = 64 * 1024 });
+    defer arena.deinit();
+
+    for (0..256) |_| {
+        _ = try arena.alloc(64);
+    }
+    // 16 KiB of small allocations fit in the first, rounded-up block.
+    try std.testing.expectEqual(@as(usize, 1), arena.zig_alloc.blocks.count());
+}
+
+test "Arena: max_block_size caps rounding but not large requests" {
+    const arena = try Arena.initWithOptions(std.testing.allocator, .{
+        .min_block_size = 64 * 1024,
+        .max_block_size = 4 * 1024,
+    });
+    defer arena.deinit();
+
+    const big = try arena.alloc(32 * 1024);
+    try std.testing.expectEqual(@as(usize, 32 * 1024), big.len);
+    var it = arena.zig_alloc.blocks.iterator();
+    while (it.next()) |block| {
+        try std.testing.expect(block.len < 64 * 1024);
+    }
+}
+
+test "Arena: block table spills past its inline slots" {
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+
+    // Each request is larger than what is left of the current block.
+    for (0..16) |_| {
+        _ = try arena.alloc(1024 * 1024);
+    }
+    try std.testing.expect(arena.zig_alloc.blocks.count() > ZigUpbAlloc.BlockTable.inline_capacity);
+    var requested: usize = 0;
+    var it = arena.zig_alloc.blocks.iterator();
+    while (it.next()) |block| requested += block.requested;
+    try std.testing.expectEqual(requested, arena.stats().requested);
+}
+
+test "Arena: initWithBuffer serves small allocations from the buffer" {
+    var buffer: [2048]u8 align(16) = undefined;
+    // The failing allocator proves nothing reaches the fallback.
+    const arena = try Arena.initWithBuffer(&buffer, std.testing.failing_allocator);
+    defer arena.deinit();
+
+    const mem = try arena.alloc(256);
+    const addr = @intFromPtr(mem.ptr);
+    try std.testing.expect(addr >= @intFromPtr(&buffer) and addr < @intFromPtr(&buffer) + buffer.len);
+}
+
+test "Arena: initWithBuffer falls back to the allocator when full" {
+    var buffer: [1024]u8 = undefined;
+    const arena = try Arena.initWithBuffer(&buffer, std.testing.allocator);
+    defer arena.deinit();
+
+    const mem = try arena.alloc(8 * 1024);
+    try std.testing.expectEqual(@as(usize, 8 * 1024), mem.len);
+    try std.testing.expect(arena.zig_alloc.blocks.count() > 0);
+    // Only the fallback block counts as requested; the buffer is reserved.
+    const stats = arena.stats();
+    try std.testing.expect(stats.requested >= 8 * 1024);
+    try std.testing.expect(stats.requested < stats.reserved);
+}
+
+test "Arena: initWithBufferOptions applies max_bytes past the buffer" {
+    var buffer: [4096]u8 = undefined;
+    const arena = try Arena.initWithBufferOptions(&buffer, std.testing.allocator, .{ .max_bytes = 8 * 1024 });
+    defer arena.deinit();
+
+    // The buffer counts towards the budget, so only ~4 KiB more fits.
+    _ = try arena.alloc(2 * 1024);
+    try std.testing.expectError(error.OutOfMemory, arena.alloc(8 * 1024));
+    try std.testing.expect(arena.stats().refused > 0);
+}
+
+test "Arena: reset reuses its largest block" {
+    var arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+
+    _ = try arena.alloc(16 * 1024);
+    try arena.reset();
+    // The retained block became the fresh arena's first block.
+    try std.testing.expectEqual(@as(usize, 1), arena.zig_alloc.blocks.count());
+    const retained = arena.zig_alloc.blocks.inline_addrs[0];
+    const retained_len = arena.zig_alloc.blocks.inline_blocks[0].len;
+    try std.testing.expect(retained_len >= 16 * 1024);
+
+    // The same workload now fits in the retained block.
+    const mem = try arena.alloc(8 * 1024);
+    try std.testing.expect(@intFromPtr(mem.ptr) >= retained);
+    try std.testing.expect(@intFromPtr(mem.ptr) < retained + retained_len);
+    try std.testing.expectEqual(@as(usize, 1), arena.zig_alloc.blocks.count());
+}
+
+test "Arena: a reset arena can still be fused" {
+    var arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    const other = try Arena.init(std.testing.allocator);
+    defer other.deinit();
+
+    _ = try arena.alloc(4096);
+    try arena.reset();
+    try arena.fuse(other);
+}
+
+test "Arena: a failed reset leaves an arena deinit can free" {
+    var arena = try Arena.initWithOptions(std.testing.allocator, .{ .max_retained_block = 0 });
+    _ = try arena.alloc(4096);
+    // Nothing is retained and the budget refuses a new first block.
+    arena.zig_alloc.options.max_bytes = 1;
+    try std.testing.expectError(error.OutOfMemory, arena.reset());
+    try std.testing.expectEqual(@as(usize, 0), arena.zig_alloc.reservedBytes());
+    arena.deinit();
+}
+
+test "Arena: reset does not retain blocks above the cap" {
+    var arena = try Arena.initWithOptions(std.testing.allocator, .{ .max_retained_block = 1024 });
+    defer arena.deinit();
+
+    _ = try arena.alloc(16 * 1024);
+    try arena.reset();
+    try std.testing.expect(arena.stats().reserved < 16 * 1024);
+}
+
+test "ArenaPool: recycles arenas on the same thread" {
+    const pool = ArenaPool.init(std.testing.allocator, .{});
+    defer pool.trimThread();
+
+    const first = try pool.acquire();
+    _ = try first.alloc(4096);
+    pool.release(first);
+
+    const second = try pool.acquire();
+    try std.testing.expectEqual(first.zig_alloc, second.zig_alloc);
+    // The retained block serves the next request without new blocks.
+    _ = try second.alloc(1024);
+    try std.testing.expectEqual(@as(usize, 1), second.zig_alloc.blocks.count());
+    pool.release(second);
+}
+
+test "ArenaPool: destroys arenas above the high-water mark" {
+    const pool = ArenaPool.init(std.testing.allocator, .{ .high_water_bytes = 0 });
+    defer pool.trimThread();
+
+    const arena = try pool.acquire();
+    _ = try arena.alloc(4096);
+    pool.release(arena);
+    try std.testing.expectEqual(@as(usize, 0), pool.idleBytes());
+}
+
+test "ArenaPool: pools keep separate idle lists and high-water marks" {
+    const a = ArenaPool.init(std.testing.allocator, .{ .high_water_bytes = 64 * 1024 });
+    defer a.trimThread();
+    const b = ArenaPool.init(std.testing.allocator, .{ .high_water_bytes = 64 * 1024 });
+    defer b.trimThread();
+
+    const from_a = try a.acquire();
+    _ = try from_a.alloc(4096);
+    a.release(from_a);
+    const from_b = try b.acquire();
+    _ = try from_b.alloc(4096);
+    b.release(from_b);
+    try std.testing.expect(a.idleBytes() > 0);
+    try std.testing.expect(b.idleBytes() > 0);
+
+    // A copy of a pool shares its idle list.
+    const copy = a;
+    const again = try copy.acquire();
+    try std.testing.expectEqual(from_a.zig_alloc, again.zig_alloc);
+    try std.testing.expectEqual(@as(usize, 0), a.idleBytes());
+    copy.release(again);
+}
+
+test "Arena: stats report rounding and peak usage" {
+    var arena = try Arena.initWithOptions(std.testing.allocator, .{ .min_block_size = 64 * 1024 });
+    defer arena.deinit();
+
+    _ = try arena.alloc(1024);
+    const before = arena.stats();
+    try std.testing.expectEqual(@as(usize, 1), before.blocks);
+    try std.testing.expectEqual(@as(usize, 64 * 1024), before.reserved);
+    try std.testing.expect(before.requested < before.reserved);
+    try std.testing.expect(before.space_allocated > 0);
+    try std.testing.expectEqual(@as(usize, 1), before.fused_count);
+
+    // The block is retained as the first block; the peak survives reset.
+    try arena.reset();
+    const after = arena.stats();
+    try std.testing.expectEqual(@as(usize, 1), after.blocks);
+    try std.testing.expectEqual(before.reserved, after.peak_reserved);
+}
+
+test "Arena: max_bytes refuses allocations past the budget" {
+    const arena = try Arena.initWithOptions(std.testing.allocator, .{
+        .min_block_size = 64 * 1024,
+        .max_bytes = 16 * 1024,
+    });
+    defer arena.deinit();
+
+    // Rounding stops at the budget rather than failing.
+    _ = try arena.alloc(1024);
+    try std.testing.expectError(error.OutOfMemory, arena.alloc(32 * 1024));
+    const stats = arena.stats();
+    try std.testing.expect(stats.refused > 0);
+    try std.testing.expect(stats.reserved <= 16 * 1024);
+}
+
+test "decode: reports ArenaBudgetExceeded" {
+    const mt = try testMiniTable();
+    const arena = try Arena.initWithOptions(std.testing.allocator, .{ .max_bytes = 4 * 1024 });
+    defer arena.deinit();
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+
+    // Field 3 (string) with an 8 KiB payload, which decode copies into the arena.
+    var data: [3 + 8 * 1024]u8 = undefined;
+    data[0..3].* = .{ 0x1a, 0x80, 0x40 };
+    @memset(data[3..], 'x');
+    try std.testing.expectError(error.ArenaBudgetExceeded, decode(msg, mt, &data, arena));
+}
+
+test "encode: a scratch arena keeps the encoding out of the message's arena" {
+    const mt = try testMiniTable();
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    var scratch = try Arena.init(std.testing.allocator);
+    defer scratch.deinit();
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    setInt32(msg, findFieldByNumber(mt, 1).?, 150);
+    setString(msg, findFieldByNumber(mt, 3).?, "hi");
+
+    const before = c.upb_zig_Arena_Remaining(arena.ptr);
+    const bytes = try encode(msg, mt, scratch);
+    try std.testing.expectEqual(before, c.upb_zig_Arena_Remaining(arena.ptr));
+    try std.testing.expectEqualSlices(u8, try encode(msg, mt, arena), bytes);
+    try scratch.reset();
+}
+
+test "encodeTo: streams a message that decodes like encode()" {
+    const mt = try testMiniTable();
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    var scratch = try Arena.init(std.testing.allocator);
+    defer scratch.deinit();
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    setInt32(msg, findFieldByNumber(mt, 1).?, 150);
+    setString(msg, findFieldByNumber(mt, 3).?, "hi");
+
+    var out: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer out.deinit();
+    try encodeTo(msg, mt, &scratch, &out.writer);
+    try std.testing.expectEqualSlices(u8, try encode(msg, mt, arena), out.written());
+}
+
+test "encodeTo: writes repeated strings after the rest of the message" {
+    // MiniDescriptor for: repeated string a = 1; int32 b = 2;
+    const mt = buildMiniTable("$E(") orelse return error.BuildFailed;
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    var scratch = try Arena.init(std.testing.allocator);
+    defer scratch.deinit();
+    const a = findFieldByNumber(mt, 1).?;
+    const b = findFieldByNumber(mt, 2).?;
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try arrayAppendString(msg, a, "first", arena);
+    try arrayAppendString(msg, a, "second", arena);
+    setInt32(msg, b, 7);
+
+    var out: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer out.deinit();
+    try encodeTo(msg, mt, &scratch, &out.writer);
+    try std.testing.expectEqual(@as(u8, 0x10), out.written()[0]); // field 2 first
+
+    const decoded = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try decode(decoded, mt, out.written(), arena);
+    try std.testing.expectEqual(@as(i32, 7), getInt32(decoded, b, 0));
+    try std.testing.expectEqual(@as(usize, 2), getArrayLen(decoded, a));
+    try std.testing.expectEqualStrings("second", arrayGetString(decoded, a, 1));
+}
+
+test "encodeTo: streams repeated messages through their sub-table" {
+    // MiniDescriptor for: Node child = 1; repeated Node children = 2;
+    const mt = buildMiniTable("$3G") orelse return error.BuildFailed;
+    const subs = [_]?*const c.upb_MiniTable{ mt, mt };
+    try std.testing.expect(linkMiniTable(mt, &subs, &.{}));
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    var scratch = try Arena.init(std.testing.allocator);
+    defer scratch.deinit();
+    const child = findFieldByNumber(mt, 1).?;
+    const children = findFieldByNumber(mt, 2).?;
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    _ = try getOrCreateMessage(msg, mt, child, arena);
+    const first = try arrayAppendNewMessage(msg, mt, children, arena);
+    _ = try getOrCreateMessage(first, mt, child, arena);
+    _ = try arrayAppendNewMessage(msg, mt, children, arena);
+
+    var out: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer out.deinit();
+    try encodeTo(msg, mt, &scratch, &out.writer);
+
+    const decoded = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try decode(decoded, mt, out.written(), arena);
+    try std.testing.expect(getMessage(decoded, child) != null);
+    try std.testing.expectEqual(@as(usize, 2), getArrayLen(decoded, children));
+    try std.testing.expect(getMessage(arrayGetMessage(decoded, children, 0).?, child) != null);
+}
+
+test "decodeWithOptions: alias_string points into the input" {
+    const mt = try testMiniTable();
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    const field = findFieldByNumber(mt, 3).?;
+    const data = [_]u8{ 0x1a, 0x02, 'h', 'i' };
+
+    const copied = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try decode(copied, mt, &data, arena);
+    try std.testing.expect(getString(copied, field, "").ptr != data[2..].ptr);
+
+    const aliased = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try decodeWithOptions(aliased, mt, &data, arena, .{ .alias_string = true });
+    try std.testing.expectEqual(@as([*]const u8, data[2..].ptr), getString(aliased, field, "").ptr);
+}
+
+test "decodeWithOptions: discard_unknown drops unknown fields" {
+    const mt = try testMiniTable();
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    // Field 1 = 5, then unknown field 9 = 1.
+    const data = [_]u8{ 0x08, 0x05, 0x48, 0x01 };
+
+    const kept = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try decode(kept, mt, &data, arena);
+    try std.testing.expectEqual(@as(usize, 4), (try encode(kept, mt, arena)).len);
+
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try decodeWithOptions(msg, mt, &data, arena, .{ .discard_unknown = true });
+    try std.testing.expectEqualSlices(u8, data[0..2], try encode(msg, mt, arena));
+}
+
+test "decodeWithOptions: discard_unknown reaches map values" {
+    // MiniDescriptors for: map<string, Leaf> m = 1; where Leaf is testMiniTable().
+    const leaf = try testMiniTable();
+    const entry = buildMiniTable("%13") orelse return error.BuildFailed;
+    try std.testing.expect(linkMiniTable(entry, &[_]?*const c.upb_MiniTable{leaf}, &.{}));
+    const mt = buildMiniTable("$G") orelse return error.BuildFailed;
+    try std.testing.expect(linkMiniTable(mt, &[_]?*const c.upb_MiniTable{entry}, &.{}));
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    // Entry "k" whose value holds only unknown field 9 = 1.
+    const data = [_]u8{ 0x0a, 0x07, 0x0a, 0x01, 'k', 0x12, 0x02, 0x48, 0x01 };
+
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try decodeWithOptions(msg, mt, &data, arena, .{ .discard_unknown = true });
+    try std.testing.expectEqual(data.len - 2, (try encode(msg, mt, arena)).len);
+}
+
+test "decodeWithOptions: discard_unknown keeps unknown bytes out of the arena only with alias_string" {
+    const mt = try testMiniTable();
+    // Field 1 = 5, then unknown field 9 with an 8 KiB payload.
+    var data: [5 + 8 * 1024]u8 = undefined;
+    data[0..5].* = .{ 0x08, 0x05, 0x4a, 0x80, 0x40 };
+    @memset(data[5..], 'x');
+
+    const copied = try Arena.init(std.testing.allocator);
+    defer copied.deinit();
+    const a = messageNew(mt, copied) orelse return error.OutOfMemory;
+    try decodeWithOptions(a, mt, &data, copied, .{ .discard_unknown = true });
+    try std.testing.expect(copied.stats().reserved >= 8 * 1024);
+
+    const aliased = try Arena.init(std.testing.allocator);
+    defer aliased.deinit();
+    const b = messageNew(mt, aliased) orelse return error.OutOfMemory;
+    try decodeWithOptions(b, mt, &data, aliased, .{ .discard_unknown = true, .alias_string = true });
+    try std.testing.expect(aliased.stats().reserved < 8 * 1024);
+    try std.testing.expectEqualSlices(u8, data[0..2], try encode(b, mt, aliased));
+}
+
+test "encodeWithOptions: skip_unknown leaves out unknown fields" {
+    const mt = try testMiniTable();
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    // Field 1 = 5, then unknown field 9 = 1.
+    const data = [_]u8{ 0x08, 0x05, 0x48, 0x01 };
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try decode(msg, mt, &data, arena);
+
+    const encoded = try encodeWithOptions(msg, mt, arena, .{ .deterministic = true, .skip_unknown = true });
+    try std.testing.expectEqualSlices(u8, data[0..2], encoded);
+}
+
+test "decodeWithOptions: max_depth bounds nesting" {
+    // MiniDescriptor for: message M { M child = 1; }
+    const mt = buildMiniTable("$3") orelse return error.BuildFailed;
+    const subs = [_]?*const c.upb_MiniTable{mt};
+    try std.testing.expect(linkMiniTable(mt, &subs, &.{}));
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    // Three levels of child.
+    const data = [_]u8{ 0x0a, 0x04, 0x0a, 0x02, 0x0a, 0x00 };
+
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try decode(msg, mt, &data, arena);
+    try std.testing.expectError(error.MaxDepthExceeded, decodeWithOptions(msg, mt, &data, arena, .{ .max_depth = 2 }));
+}
+
+test "arraySlice: views repeated elements in place" {
+    // MiniDescriptor for: repeated int32 a = 1;
+    const mt = buildMiniTable("$<") orelse return error.BuildFailed;
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    const field = findFieldByNumber(mt, 1).?;
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try std.testing.expectEqual(@as(usize, 0), arraySlice(i32, msg, field).len);
+
+    for (0..5) |i| try arrayAppendInt32(msg, field, @intCast(i * 10), arena);
+    try std.testing.expectEqualSlices(i32, &.{ 0, 10, 20, 30, 40 }, arraySlice(i32, msg, field));
+}
+
+test "arrayAppendSlice: bulk appends and replaces" {
+    // MiniDescriptor for: repeated int32 a = 1;
+    const mt = buildMiniTable("$<") orelse return error.BuildFailed;
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    const field = findFieldByNumber(mt, 1).?;
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+
+    try arrayReserve(msg, field, 8, arena);
+    try arrayAppendInt32(msg, field, 1, arena);
+    try arrayAppendSlice(i32, msg, field, &.{ 2, 3, 4 }, arena);
+    try std.testing.expectEqualSlices(i32, &.{ 1, 2, 3, 4 }, arraySlice(i32, msg, field));
+
+    try arraySetSlice(i32, msg, field, &.{ 9, 8 }, arena);
+    try std.testing.expectEqualSlices(i32, &.{ 9, 8 }, arraySlice(i32, msg, field));
+}
+
+test "arraySet: updates repeated fields in place" {
+    // MiniDescriptor for: repeated int32 a = 1;
+    const mt = buildMiniTable("$<") orelse return error.BuildFailed;
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    const field = findFieldByNumber(mt, 1).?;
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+    try std.testing.expectError(error.IndexOutOfBounds, arraySet(i32, msg, field, 0, 1));
+
+    try arrayAppendSlice(i32, msg, field, &.{ 1, 2, 3, 4, 5 }, arena);
+    try arraySet(i32, msg, field, 1, 20);
+    try arraySwapRemove(i32, msg, field, 0, arena);
+    try std.testing.expectEqualSlices(i32, &.{ 5, 20, 3, 4 }, arraySlice(i32, msg, field));
+    arrayTruncate(msg, field, 2, arena);
+    try std.testing.expectEqualSlices(i32, &.{ 5, 20 }, arraySlice(i32, msg, field));
+    arrayTruncate(msg, field, 0, arena);
+    try std.testing.expectEqual(@as(usize, 0), getArrayLen(msg, field));
+}
+
+test "getOrCreateMessage and arrayAppendNewMessage: build sub-messages in place" {
+    // MiniDescriptor for: M child = 1; repeated M children = 2; (M is self)
+    const mt = buildMiniTable("$3G") orelse return error.BuildFailed;
+    const subs = [_]?*const c.upb_MiniTable{ mt, mt };
+    try std.testing.expect(linkMiniTable(mt, &subs, &.{}));
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    const child = findFieldByNumber(mt, 1).?;
+    const children = findFieldByNumber(mt, 2).?;
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+
+    const sub = try getOrCreateMessage(msg, mt, child, arena);
+    try std.testing.expectEqual(sub, getMessage(msg, child).?);
+    try std.testing.expectEqual(sub, try getOrCreateMessage(msg, mt, child, arena));
+
+    _ = try arrayAppendNewMessage(msg, mt, children, arena);
+    const second = try arrayAppendNewMessage(msg, mt, children, arena);
+    try std.testing.expectEqual(@as(usize, 2), getArrayLen(msg, children));
+    try std.testing.expectEqual(second, arrayGetMessage(msg, children, 1).?);
+}
+
+test "mapPut: looks up, iterates and removes entries" {
+    // MiniDescriptor for: map<string, int32> m = 1;
+    const mt = buildMiniTable("$G") orelse return error.BuildFailed;
+    const entry = buildMiniTable("%1(") orelse return error.BuildFailed;
+    const subs = [_]?*const c.upb_MiniTable{entry};
+    try std.testing.expect(linkMiniTable(mt, &subs, &.{}));
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    const field = findFieldByNumber(mt, 1).?;
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+
+    try mapPut([]const u8, i32, msg, mt, field, "a", 1, arena);
+    try mapPut([]const u8, i32, msg, mt, field, "b", 2, arena);
+    try mapPut([]const u8, i32, msg, mt, field, "a", 3, arena);
+    try std.testing.expectEqual(@as(usize, 2), mapCount(msg, field));
+    try std.testing.expectEqual(@as(?i32, 3), mapGet([]const u8, i32, msg, field, "a"));
+    try std.testing.expectEqual(@as(?i32, null), mapGet([]const u8, i32, msg, field, "c"));
+
+    var sum: i32 = 0;
+    var it = mapIterator([]const u8, i32, msg, field);
+    while (it.next()) |e| sum += e.value;
+    try std.testing.expectEqual(@as(i32, 5), sum);
+
+    try std.testing.expect(mapRemove([]const u8, msg, field, "b"));
+    try std.testing.expect(!mapRemove([]const u8, msg, field, "b"));
+    mapClear(msg, field);
+    try std.testing.expectEqual(@as(usize, 0), mapCount(msg, field));
+}
+
+test "Arena: fused arenas free their memory together" {
+    const a = try Arena.init(std.testing.allocator);
+    const b = try Arena.init(std.testing.allocator);
+    try a.fuse(b);
+
+    const mem = try b.alloc(64);
+    @memset(mem, 0xCC);
+    // b's memory stays valid until a is freed as well.
+    b.deinit();
+    try std.testing.expectEqual(@as(u8, 0xCC), mem[63]);
+    a.deinit();
+}
+
+test "adoptMessage: fails when the arenas cannot be fused" {
+    const mt = try testMiniTable();
+    var buffer: [4096]u8 align(16) = undefined;
+    const into = try Arena.initWithBuffer(&buffer, std.testing.allocator);
+    defer into.deinit();
+    const from = try Arena.init(std.testing.allocator);
+    defer from.deinit();
+
+    const msg = messageNew(mt, from) orelse return error.OutOfMemory;
+    try std.testing.expectError(error.ArenaFuseFailed, adoptMessage(into, from, msg));
+    const copy = try cloneMessage(msg, mt, into);
+    try std.testing.expectEqual(copy, try adoptMessage(into, into, copy));
+}
+
+test "Native accessors: match the upb C accessors" {
+    const mt = try testMiniTable();
+    const arena = try Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    const msg = messageNew(mt, arena) orelse return error.OutOfMemory;
+
+    const a = findFieldByNumber(mt, 1).?;
+    const b = findFieldByNumber(mt, 2).?;
+    const str = findFieldByNumber(mt, 3).?;
+    const d = findFieldByNumber(mt, 4).?;
+    const e = findFieldByNumber(mt, 5).?;
+    const f = findFieldByNumber(mt, 6).?;
+
+    // Unset fields return their defaults
+    try std.testing.expectEqual(c.upb_zig_Message_GetInt32(msg, a, 7), nativeGet(i32, msg, a, 7));
+    try std.testing.expectEqual(@as(i32, 7), nativeGet(i32, msg, a, 7));
+    try std.testing.expectEqual(@as(f64, 1.5), nativeGet(f64, msg, b, 1.5));
+    try std.testing.expectEqualStrings("x", fromStringView(nativeGet(c.upb_StringView, msg, str, toStringView("x"))));
+    try std.testing.expect(!nativeHas(@ptrCast(msg), fieldLayout(a)));
+
+    // Native setters are visible to the C getters and vice versa
+    nativeSet(i32, msg, a, -3);
+    nativeSet(f64, msg, b, 2.25);
+    nativeSet(c.upb_StringView, msg, str, toStringView("hello"));
+    nativeSet(u8, msg, d, 1);
+    try std.testing.expectEqual(@as(i32, -3), c.upb_zig_Message_GetInt32(msg, a, 7));
+    try std.testing.expectEqual(@as(f64, 2.25), c.upb_zig_Message_GetDouble(msg, b, 0));
+    try std.testing.expectEqualStrings("hello", fromStringView(c.upb_zig_Message_GetString(msg, str, toStringView(""))));
+    try std.testing.expect(c.upb_zig_Message_GetBool(msg, d, false));
+    try std.testing.expect(c.upb_zig_Message_HasField(msg, a));
+
+    c.upb_zig_Message_SetInt32(msg, a, 11);
+    try std.testing.expectEqual(@as(i32, 11), nativeGet(i32, msg, a, 0));
+
+    // Setting one oneof member clears the other
+    nativeSet(i64, msg, e, 99);
+    try std.testing.expectEqual(@as(i64, 99), c.upb_zig_Message_GetInt64(msg, e, 0));
+    nativeSet(f32, msg, f, 0.5);
+    try std.testing.expect(!c.upb_zig_Message_HasField(msg, e));
+    try std.testing.expect(!nativeHas(@ptrCast(msg), fieldLayout(e)));
+    try std.testing.expectEqual(@as(i64, 0), nativeGet(i64, msg, e, 0));
+    try std.testing.expectEqual(@as(f32, 0.5), c.upb_zig_Message_GetFloat(msg, f, 0));
+}